@@ -0,0 +1,472 @@
+#define _GNU_SOURCE
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+
+#define DYNAMIC_LIST_IMPL
+#include "dynamic_list.h"
+
+// measures list kernels with hardware performance counters and prints the results as JSON.
+// linux only, since the counters come from perf_event_open. counters the kernel refuses to open
+// (no PMU in a VM, perf_event_paranoid too high) are reported as null.
+//
+//     $ gcc bench.c -std=c11 -O3 -o bench -lm
+//     $ ./bench [items] [--trials N] [--save FILE] [--compare FILE] [--threshold PERCENT]
+//
+// every kernel is timed --trials times (default: 15). the reported seconds and counters are those
+// of the median trial. --save writes every trial's time to a baseline file; --compare reads one
+// back and tests each kernel with a one-sided Mann-Whitney U test. a kernel is flagged as a
+// regression when it's slower with p < 0.05 and its median grew by more than --threshold percent
+// (default: 5), and the exit status is then 2.
+
+typedef struct
+{
+    const char* name;
+    unsigned int type;
+    unsigned long long config;
+} Counter;
+
+static const Counter counters[] = {
+    {"cycles", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+    {"instructions", PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+    {"cache_misses", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES},
+    {"branch_misses", PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES},
+    {"page_faults", PERF_TYPE_SOFTWARE, PERF_COUNT_SW_PAGE_FAULTS},
+};
+
+#define COUNTER_COUNT (sizeof(counters) / sizeof(counters[0]))
+
+typedef struct
+{
+    int fds[COUNTER_COUNT];
+    unsigned long long values[COUNTER_COUNT];
+} Counters;
+
+static void counters_open(Counters* c)
+{
+    for (size_t i = 0; i < COUNTER_COUNT; i++)
+    {
+        struct perf_event_attr attr;
+        memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = counters[i].type;
+        attr.config = counters[i].config;
+        attr.disabled = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+
+        // each counter is opened on its own rather than as a group, so one unsupported event
+        // doesn't take the others down with it
+        c->fds[i] = (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+    }
+}
+
+static void counters_close(Counters* c)
+{
+    for (size_t i = 0; i < COUNTER_COUNT; i++)
+    {
+        if (c->fds[i] >= 0)
+            close(c->fds[i]);
+    }
+}
+
+static void counters_start(Counters* c)
+{
+    for (size_t i = 0; i < COUNTER_COUNT; i++)
+    {
+        if (c->fds[i] >= 0)
+        {
+            ioctl(c->fds[i], PERF_EVENT_IOC_RESET, 0);
+            ioctl(c->fds[i], PERF_EVENT_IOC_ENABLE, 0);
+        }
+    }
+}
+
+static void counters_stop(Counters* c)
+{
+    for (size_t i = 0; i < COUNTER_COUNT; i++)
+    {
+        c->values[i] = 0;
+        if (c->fds[i] >= 0)
+        {
+            ioctl(c->fds[i], PERF_EVENT_IOC_DISABLE, 0);
+            if (read(c->fds[i], &c->values[i], sizeof(c->values[i])) != sizeof(c->values[i]))
+                c->values[i] = 0;
+        }
+    }
+}
+
+static double now_seconds(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+static volatile long long sink;
+
+// appends one item at a time, growing from the default capacity
+static void bench_append(const size_t items)
+{
+    int* list = list_new(int);
+    for (size_t i = 0; i < items; i++)
+        list_append(list, (int)i);
+
+    sink += list[items - 1];
+    list_free(list);
+}
+
+// only the reallocations: capacity doubles from 1 without writing any items
+static void bench_growth(const size_t items)
+{
+    for (size_t round = 0; round < 16; round++)
+    {
+        int* list = create_list(sizeof(int), 1, NULL);
+        for (size_t length = 1; length < items; length *= 2)
+        {
+            list = list_ensure_capacity(list, length, sizeof(int));
+            list_len(list) = length;
+        }
+
+        sink += (long long)list_cap(list);
+        list_free(list);
+    }
+}
+
+// removes from the front of a full list until it's empty, each remove copying the last item in
+static void bench_remove_at(const size_t items)
+{
+    int* list = list_new(int);
+    list_resize(list, items);
+    for (size_t i = 0; i < items; i++)
+        list[i] = (int)i;
+
+    while (list_len(list) > 0)
+        list_remove_at(list, 0);
+
+    sink += (long long)list_cap(list);
+    list_free(list);
+}
+
+// looks up keys spread over a full list with a linear scan, as code without an index would
+static void bench_search(const size_t items)
+{
+    int* list = list_new(int);
+    list_resize(list, items);
+    for (size_t i = 0; i < items; i++)
+        list[i] = (int)i;
+
+    long long found = 0;
+    for (size_t key = 0; key < 16; key++)
+    {
+        const int target = (int)(items / 16 * key + key);
+        for (size_t i = 0; i < list_len(list); i++)
+        {
+            if (list[i] == target)
+            {
+                found += (long long)i;
+                break;
+            }
+        }
+    }
+
+    sink += found;
+    list_free(list);
+}
+
+// sums a full list, reading the length from the prelude on every iteration
+static void bench_iterate(const size_t items)
+{
+    int* list = list_new(int);
+    list_resize(list, items);
+    for (size_t i = 0; i < items; i++)
+        list[i] = (int)i;
+
+    long long sum = 0;
+    for (size_t round = 0; round < 16; round++)
+    {
+        for (size_t i = 0; i < list_len(list); i++)
+            sum += list[i];
+    }
+
+    sink += sum;
+    list_free(list);
+}
+
+typedef struct
+{
+    const char* name;
+    void (*run)(size_t items);
+} Kernel;
+
+static const Kernel kernels[] = {
+    {"append", bench_append},
+    {"growth", bench_growth},
+    {"remove_at", bench_remove_at},
+    {"iterate", bench_iterate},
+    {"search", bench_search},
+};
+
+#define KERNEL_COUNT (sizeof(kernels) / sizeof(kernels[0]))
+#define MAX_TRIALS 256
+#define SIGNIFICANCE 0.05
+
+typedef struct
+{
+    char name[32];
+    size_t trials;
+    double seconds[MAX_TRIALS];
+} Baseline;
+
+static int compare_doubles(const void* a, const void* b)
+{
+    const double x = *(const double*)a;
+    const double y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+static double median(const double* values, const size_t count)
+{
+    double sorted[MAX_TRIALS];
+    memcpy(sorted, values, count * sizeof(double));
+    qsort(sorted, count, sizeof(double), compare_doubles);
+    return count % 2 ? sorted[count / 2] : (sorted[count / 2 - 1] + sorted[count / 2]) / 2;
+}
+
+typedef struct
+{
+    double value;
+    int current;
+} Sample;
+
+static int compare_samples(const void* a, const void* b)
+{
+    return compare_doubles(&((const Sample*)a)->value, &((const Sample*)b)->value);
+}
+
+// p-value of the one-sided Mann-Whitney U test that `current` tends to be larger than `baseline`,
+// using the normal approximation with a tie and continuity correction
+static double mann_whitney(const double* current, const size_t n1, const double* baseline, const size_t n2)
+{
+    Sample samples[MAX_TRIALS * 2];
+    const size_t n = n1 + n2;
+    for (size_t i = 0; i < n1; i++)
+        samples[i] = (Sample){current[i], 1};
+    for (size_t i = 0; i < n2; i++)
+        samples[n1 + i] = (Sample){baseline[i], 0};
+    qsort(samples, n, sizeof(Sample), compare_samples);
+
+    double rank_sum = 0;
+    double ties = 0;
+    for (size_t i = 0; i < n;)
+    {
+        size_t j = i;
+        while (j < n && samples[j].value == samples[i].value)
+            j++;
+
+        // tied values share the average of the ranks they span
+        const double rank = (double)(i + j + 1) / 2;
+        for (size_t k = i; k < j; k++)
+        {
+            if (samples[k].current)
+                rank_sum += rank;
+        }
+
+        const double t = (double)(j - i);
+        ties += t * t * t - t;
+        i = j;
+    }
+
+    const double u = rank_sum - (double)n1 * (double)(n1 + 1) / 2;
+    const double mean = (double)n1 * (double)n2 / 2;
+    const double variance = (double)n1 * (double)n2 / 12 * ((double)(n + 1) - ties / ((double)n * (double)(n - 1)));
+    if (variance <= 0)
+        return 1;
+
+    const double z = (u - mean - 0.5) / sqrt(variance);
+    return 0.5 * erfc(z / sqrt(2));
+}
+
+static size_t load_baseline(const char* path, size_t* items, Baseline* baselines)
+{
+    FILE* file = fopen(path, "r");
+    if (!file)
+        return 0;
+
+    size_t count = 0;
+    char word[32];
+    while (fscanf(file, "%31s", word) == 1)
+    {
+        if (strcmp(word, "items") == 0)
+        {
+            if (fscanf(file, "%zu", items) != 1)
+                break;
+        }
+        else if (strcmp(word, "kernel") == 0 && count < KERNEL_COUNT)
+        {
+            // the median needs a trial and the rank test needs two
+            Baseline* baseline = &baselines[count];
+            if (fscanf(file, "%31s %zu", baseline->name, &baseline->trials) != 2 || baseline->trials < 2
+                || baseline->trials > MAX_TRIALS)
+                break;
+
+            size_t read = 0;
+            while (read < baseline->trials && fscanf(file, "%lf", &baseline->seconds[read]) == 1)
+                read++;
+            if (read != baseline->trials)
+                break;
+            count++;
+        }
+    }
+
+    fclose(file);
+    return count;
+}
+
+static int save_baseline(const char* path, const size_t items, const Baseline* results)
+{
+    FILE* file = fopen(path, "w");
+    if (!file)
+        return -1;
+
+    fprintf(file, "items %zu\n", items);
+    for (size_t k = 0; k < KERNEL_COUNT; k++)
+    {
+        fprintf(file, "kernel %s %zu", results[k].name, results[k].trials);
+        for (size_t t = 0; t < results[k].trials; t++)
+            fprintf(file, " %.9f", results[k].seconds[t]);
+        fprintf(file, "\n");
+    }
+
+    return fclose(file) == 0 ? 0 : -1;
+}
+
+static void usage(const char* program)
+{
+    fprintf(stderr, "usage: %s [items] [--trials N] [--save FILE] [--compare FILE] [--threshold PERCENT]\n", program);
+}
+
+int main(int argc, char* argv[])
+{
+    size_t items = 1 << 22;
+    size_t trials = 15;
+    const char* save = NULL;
+    const char* compare = NULL;
+    double threshold = 5;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--trials") == 0 && i + 1 < argc)
+            trials = strtoull(argv[++i], NULL, 10);
+        else if (strcmp(argv[i], "--save") == 0 && i + 1 < argc)
+            save = argv[++i];
+        else if (strcmp(argv[i], "--compare") == 0 && i + 1 < argc)
+            compare = argv[++i];
+        else if (strcmp(argv[i], "--threshold") == 0 && i + 1 < argc)
+            threshold = strtod(argv[++i], NULL);
+        else if (argv[i][0] != '-')
+            items = strtoull(argv[i], NULL, 10);
+        else
+            items = 0;
+    }
+    if (items == 0 || trials == 0 || trials > MAX_TRIALS)
+    {
+        usage(argv[0]);
+        return 1;
+    }
+
+    static Baseline baselines[KERNEL_COUNT];
+    size_t baseline_items = 0;
+    size_t baseline_count = 0;
+    if (compare)
+    {
+        baseline_count = load_baseline(compare, &baseline_items, baselines);
+        if (baseline_count == 0)
+        {
+            fprintf(stderr, "could not read a baseline from %s\n", compare);
+            return 1;
+        }
+        if (baseline_items != items)
+            fprintf(stderr, "warning: baseline was recorded with %zu items, not %zu\n", baseline_items, items);
+    }
+
+    Counters c;
+    counters_open(&c);
+
+    static Baseline results[KERNEL_COUNT];
+    static unsigned long long values[MAX_TRIALS][COUNTER_COUNT];
+    int regressions = 0;
+
+    printf("{\n  \"items\": %zu,\n  \"trials\": %zu,\n  \"kernels\": [\n", items, trials);
+    for (size_t k = 0; k < KERNEL_COUNT; k++)
+    {
+        // warm up once so first-touch page faults of the allocator's arena aren't charged to the
+        // first kernel
+        kernels[k].run(items);
+
+        Baseline* result = &results[k];
+        snprintf(result->name, sizeof(result->name), "%s", kernels[k].name);
+        result->trials = trials;
+        for (size_t t = 0; t < trials; t++)
+        {
+            counters_start(&c);
+            const double start = now_seconds();
+            kernels[k].run(items);
+            result->seconds[t] = now_seconds() - start;
+            counters_stop(&c);
+            memcpy(values[t], c.values, sizeof(c.values));
+        }
+
+        // the counters reported are the ones of the trial closest to the median time
+        const double seconds = median(result->seconds, trials);
+        size_t middle = 0;
+        for (size_t t = 1; t < trials; t++)
+        {
+            if (fabs(result->seconds[t] - seconds) < fabs(result->seconds[middle] - seconds))
+                middle = t;
+        }
+
+        printf("    {\"name\": \"%s\", \"seconds\": %.9f", kernels[k].name, seconds);
+        for (size_t i = 0; i < COUNTER_COUNT; i++)
+        {
+            if (c.fds[i] >= 0)
+                printf(", \"%s\": %llu", counters[i].name, values[middle][i]);
+            else
+                printf(", \"%s\": null", counters[i].name);
+        }
+
+        for (size_t b = 0; b < baseline_count; b++)
+        {
+            if (strcmp(baselines[b].name, kernels[k].name) != 0)
+                continue;
+
+            const double before = median(baselines[b].seconds, baselines[b].trials);
+            const double change = (seconds - before) / before * 100;
+            const double p = mann_whitney(result->seconds, trials, baselines[b].seconds, baselines[b].trials);
+            const int regression = p < SIGNIFICANCE && change > threshold;
+            regressions += regression;
+            printf(", \"baseline_seconds\": %.9f, \"change_percent\": %.2f, \"p_value\": %.6f, \"regression\": %s",
+                before, change, p, regression ? "true" : "false");
+        }
+        printf("}%s\n", k + 1 < KERNEL_COUNT ? "," : "");
+    }
+    printf("  ]\n}\n");
+
+    counters_close(&c);
+
+    if (save && save_baseline(save, items, results) != 0)
+    {
+        fprintf(stderr, "could not write the baseline to %s\n", save);
+        return 1;
+    }
+
+    if (regressions)
+        fprintf(stderr, "%d kernel%s regressed\n", regressions, regressions == 1 ? "" : "s");
+    return regressions ? 2 : 0;
+}
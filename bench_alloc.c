@@ -0,0 +1,477 @@
+#define _GNU_SOURCE
+#include <dlfcn.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+
+#define DYNAMIC_LIST_IMPL
+#include "dynamic_list.h"
+#include "support.h"
+
+// runs the same list workloads through several allocators and prints throughput, resident memory
+// and fragmentation for each pair as JSON. every pair runs in its own forked process so memory kept
+// by one allocator doesn't show up in the next one's RSS. linux only.
+//
+//     $ gcc bench_alloc.c -std=c11 -O3 -o bench_alloc -ldl
+//     $ ./bench_alloc [items]
+//
+// jemalloc and mimalloc are loaded with dlopen and skipped when they aren't installed.
+//
+// fragmentation is resident bytes gained over the run divided by the bytes the live lists have
+// reserved (prelude and capacity), so 1.0 means no overhead at all.
+
+static double now_seconds(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+static size_t resident_bytes(void)
+{
+    unsigned long pages = 0;
+    unsigned long resident = 0;
+    FILE* statm = fopen("/proc/self/statm", "r");
+    if (statm)
+    {
+        if (fscanf(statm, "%lu %lu", &pages, &resident) != 2)
+            resident = 0;
+        fclose(statm);
+    }
+    return (size_t)resident * (size_t)sysconf(_SC_PAGESIZE);
+}
+
+// every allocator below keeps the requested size in a max_align_t header in front of each block,
+// which realloc needs to know how much to copy. it's the same header the arena in support.h writes
+#define HEADER ARENA_HEADER
+
+static size_t block_size(const void* ptr)
+{
+    size_t size;
+    memcpy(&size, (const unsigned char*)ptr - HEADER, sizeof(size));
+    return size;
+}
+
+static void* block_init(void* base, const size_t size)
+{
+    if (!base)
+        return NULL;
+    memcpy(base, &size, sizeof(size));
+    return (unsigned char*)base + HEADER;
+}
+
+static size_t align_up(const size_t size, const size_t alignment)
+{
+    return (size + alignment - 1) / alignment * alignment;
+}
+
+// power of two size classes carved from 4MB slabs, with a free list per class. realloc within a
+// class returns the same block
+#define POOL_CLASSES 48
+#define POOL_SLAB ((size_t)4 << 20)
+
+typedef struct
+{
+    void* free_lists[POOL_CLASSES];
+    Arena slabs;
+} Pool;
+
+static size_t pool_class(const size_t size)
+{
+    size_t class = 0;
+    while (((size_t)16 << class) < size)
+        class++;
+    return class;
+}
+
+static void* pool_alloc(const size_t size, void* context)
+{
+    Pool* pool = context;
+    const size_t class = pool_class(size);
+    void* block = pool->free_lists[class];
+    if (block)
+    {
+        memcpy(&pool->free_lists[class], block, sizeof(void*));
+        return block_init((unsigned char*)block - HEADER, class);
+    }
+
+    // blocks are carved through the arena, whose header is reused to store the class
+    block = arena_alloc((size_t)16 << class, &pool->slabs);
+    return block ? block_init((unsigned char*)block - HEADER, class) : NULL;
+}
+
+static void pool_free(void* ptr, void* context)
+{
+    Pool* pool = context;
+    const size_t class = block_size(ptr);
+    memcpy(ptr, &pool->free_lists[class], sizeof(void*));
+    pool->free_lists[class] = ptr;
+}
+
+static void* pool_realloc(void* ptr, const size_t size, void* context)
+{
+    const size_t capacity = (size_t)16 << block_size(ptr);
+    if (size <= capacity)
+        return ptr;
+
+    void* block = pool_alloc(size, context);
+    if (block)
+    {
+        memcpy(block, ptr, capacity);
+        pool_free(ptr, context);
+    }
+    return block;
+}
+
+// one private anonymous mapping per block; growth uses mremap, which can move pages without copying
+static void* mmap_alloc(const size_t size, void* context)
+{
+    (void)context;
+    void* base = mmap(NULL, align_up(HEADER + size, (size_t)sysconf(_SC_PAGESIZE)), PROT_READ | PROT_WRITE,
+        MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    return base == MAP_FAILED ? NULL : block_init(base, size);
+}
+
+static void* mmap_realloc(void* ptr, const size_t size, void* context)
+{
+    (void)context;
+    const size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    void* base = (unsigned char*)ptr - HEADER;
+    base = mremap(base, align_up(HEADER + block_size(ptr), page), align_up(HEADER + size, page), MREMAP_MAYMOVE);
+    return base == MAP_FAILED ? NULL : block_init(base, size);
+}
+
+static void mmap_free(void* ptr, void* context)
+{
+    (void)context;
+    munmap((unsigned char*)ptr - HEADER, align_up(HEADER + block_size(ptr), (size_t)sysconf(_SC_PAGESIZE)));
+}
+
+// jemalloc and mimalloc are reached through their non-standard entry points, so they can be
+// loaded next to the libc malloc without replacing it
+typedef struct
+{
+    void* (*alloc)(size_t, int);
+    void* (*realloc)(void*, size_t, int);
+    void (*free)(void*, int);
+} Jemalloc;
+
+static void* jemalloc_alloc(const size_t size, void* context)
+{
+    return ((Jemalloc*)context)->alloc(size, 0);
+}
+
+static void* jemalloc_realloc(void* ptr, const size_t size, void* context)
+{
+    return ((Jemalloc*)context)->realloc(ptr, size, 0);
+}
+
+static void jemalloc_free(void* ptr, void* context)
+{
+    ((Jemalloc*)context)->free(ptr, 0);
+}
+
+typedef struct
+{
+    void* (*alloc)(size_t);
+    void* (*realloc)(void*, size_t);
+    void (*free)(void*);
+} Mimalloc;
+
+static void* mimalloc_alloc(const size_t size, void* context)
+{
+    return ((Mimalloc*)context)->alloc(size);
+}
+
+static void* mimalloc_realloc(void* ptr, const size_t size, void* context)
+{
+    return ((Mimalloc*)context)->realloc(ptr, size);
+}
+
+static void mimalloc_free(void* ptr, void* context)
+{
+    ((Mimalloc*)context)->free(ptr);
+}
+
+static void* open_library(const char* const* names)
+{
+    for (; *names; names++)
+    {
+        void* library = dlopen(*names, RTLD_NOW | RTLD_LOCAL);
+        if (library)
+            return library;
+    }
+    return NULL;
+}
+
+static const char* const jemalloc_names[] = {"libjemalloc.so.2", "libjemalloc.so", NULL};
+static const char* const mimalloc_names[] = {"libmimalloc.so.2", "libmimalloc.so", NULL};
+
+// fills in an Allocator for the named backend, or returns -1 if it isn't available. the contexts
+// are static, since each child process only ever opens one backend
+static int open_backend(const char* name, Allocator* allocator)
+{
+    static Arena arena;
+    static Pool pool;
+    static Jemalloc jemalloc;
+    static Mimalloc mimalloc;
+
+    if (strcmp(name, "default") == 0)
+        return 0;
+
+    if (strcmp(name, "arena") == 0)
+    {
+        *allocator = (Allocator){.alloc = arena_alloc, .realloc = arena_realloc, .free = arena_free, .context = &arena};
+        return 0;
+    }
+
+    if (strcmp(name, "pool") == 0)
+    {
+        *allocator = (Allocator){.alloc = pool_alloc, .realloc = pool_realloc, .free = pool_free, .context = &pool};
+        return 0;
+    }
+
+    if (strcmp(name, "mmap") == 0)
+    {
+        *allocator = (Allocator){.alloc = mmap_alloc, .realloc = mmap_realloc, .free = mmap_free, .context = NULL};
+        return 0;
+    }
+
+    if (strcmp(name, "jemalloc") == 0)
+    {
+        void* library = open_library(jemalloc_names);
+        if (!library)
+            return -1;
+        *(void**)&jemalloc.alloc = dlsym(library, "mallocx");
+        *(void**)&jemalloc.realloc = dlsym(library, "rallocx");
+        *(void**)&jemalloc.free = dlsym(library, "dallocx");
+        if (!jemalloc.alloc || !jemalloc.realloc || !jemalloc.free)
+            return -1;
+        *allocator = (Allocator){.alloc = jemalloc_alloc, .realloc = jemalloc_realloc, .free = jemalloc_free, .context = &jemalloc};
+        return 0;
+    }
+
+    if (strcmp(name, "mimalloc") == 0)
+    {
+        void* library = open_library(mimalloc_names);
+        if (!library)
+            return -1;
+        *(void**)&mimalloc.alloc = dlsym(library, "mi_malloc");
+        *(void**)&mimalloc.realloc = dlsym(library, "mi_realloc");
+        *(void**)&mimalloc.free = dlsym(library, "mi_free");
+        if (!mimalloc.alloc || !mimalloc.realloc || !mimalloc.free)
+            return -1;
+        *allocator = (Allocator){.alloc = mimalloc_alloc, .realloc = mimalloc_realloc, .free = mimalloc_free, .context = &mimalloc};
+        return 0;
+    }
+
+    return -1;
+}
+
+static const char* const backends[] = {"default", "arena", "pool", "mmap", "jemalloc", "mimalloc"};
+
+typedef struct
+{
+    int skipped;
+    double seconds;
+    size_t ops;
+    size_t live_bytes;
+    size_t resident_bytes;
+} Result;
+
+// each workload runs its operations, then reports the bytes its live lists have reserved at the
+// point where resident memory is sampled, before anything is freed
+typedef struct
+{
+    size_t ops;
+    size_t live_bytes;
+    size_t resident_bytes;
+} Sample;
+
+static volatile long long sink;
+
+// one list appended to until it holds `items` ints
+static Sample run_append(const size_t items, Allocator* allocator)
+{
+    int* list = list_new_alloc(int, allocator);
+    for (size_t i = 0; i < items; i++)
+        list_append(list, (int)i);
+
+    const Sample sample = {items, list_bytes_reserved(list), resident_bytes()};
+    sink += list[items - 1];
+    list_free(list);
+    return sample;
+}
+
+// a ring of 4096 live lists of 1 to 32 items, the oldest replaced by a new one at every step
+#define SMALL_LIVE 4096
+
+static Sample run_small(const size_t items, Allocator* allocator)
+{
+    static long long* lists[SMALL_LIVE];
+    Random random = {1};
+    size_t ops = 0;
+
+    for (size_t step = 0; ops < items; step++)
+    {
+        long long** slot = &lists[step % SMALL_LIVE];
+        if (*slot)
+            list_free(*slot);
+
+        *slot = list_new_alloc(long long, allocator);
+        const size_t count = 1 + random_next(&random) % 32;
+        for (size_t i = 0; i < count; i++)
+            list_append(*slot, (long long)i);
+        ops += count;
+    }
+
+    Sample sample = {ops, 0, resident_bytes()};
+    for (size_t i = 0; i < SMALL_LIVE; i++)
+    {
+        if (lists[i])
+        {
+            sample.live_bytes += list_bytes_reserved(lists[i]);
+            list_free(lists[i]);
+            lists[i] = NULL;
+        }
+    }
+    return sample;
+}
+
+// 1024 live lists grown by random amounts, each one now and then freed and started over, so
+// blocks of many sizes are released and reused in an interleaved order
+#define CHURN_LIVE 1024
+
+static Sample run_churn(const size_t items, Allocator* allocator)
+{
+    static int* lists[CHURN_LIVE];
+    Random random = {2};
+    for (size_t i = 0; i < CHURN_LIVE; i++)
+        lists[i] = list_new_alloc(int, allocator);
+
+    size_t ops = 0;
+    while (ops < items)
+    {
+        const unsigned long long r = random_next(&random);
+        int** list = &lists[r % CHURN_LIVE];
+        if ((r >> 32) % 64 == 0)
+        {
+            list_free(*list);
+            *list = list_new_alloc(int, allocator);
+        }
+
+        const size_t count = 1 + (size_t)(r >> 40) % 64;
+        for (size_t i = 0; i < count; i++)
+            list_append(*list, (int)i);
+        ops += count;
+    }
+
+    Sample sample = {ops, 0, resident_bytes()};
+    for (size_t i = 0; i < CHURN_LIVE; i++)
+    {
+        sample.live_bytes += list_bytes_reserved(lists[i]);
+        list_free(lists[i]);
+    }
+    return sample;
+}
+
+typedef struct
+{
+    const char* name;
+    Sample (*run)(size_t items, Allocator* allocator);
+} Workload;
+
+static const Workload workloads[] = {
+    {"append", run_append},
+    {"small", run_small},
+    {"churn", run_churn},
+};
+
+static Result run_child(const char* backend, const Workload* workload, const size_t items)
+{
+    Result result = {0};
+    Allocator allocator;
+    Allocator* chosen = NULL;
+    if (open_backend(backend, &allocator) != 0)
+    {
+        result.skipped = 1;
+        return result;
+    }
+    if (strcmp(backend, "default") != 0)
+        chosen = &allocator;
+
+    const size_t baseline = resident_bytes();
+    const double start = now_seconds();
+    const Sample sample = workload->run(items, chosen);
+    result.seconds = now_seconds() - start;
+    result.ops = sample.ops;
+    result.live_bytes = sample.live_bytes;
+    result.resident_bytes = sample.resident_bytes > baseline ? sample.resident_bytes - baseline : 0;
+    return result;
+}
+
+int main(int argc, char* argv[])
+{
+    const size_t items = argc > 1 ? strtoull(argv[1], NULL, 10) : 1 << 22;
+    if (items == 0)
+    {
+        fprintf(stderr, "usage: %s [items]\n", argv[0]);
+        return 1;
+    }
+
+    printf("{\n  \"items\": %zu,\n  \"runs\": [", items);
+    int first = 1;
+    for (size_t b = 0; b < sizeof(backends) / sizeof(backends[0]); b++)
+    {
+        for (size_t w = 0; w < sizeof(workloads) / sizeof(workloads[0]); w++)
+        {
+            int pipes[2];
+            if (pipe(pipes) != 0)
+                return 1;
+
+            fflush(stdout);
+            const pid_t child = fork();
+            if (child < 0)
+                return 1;
+            if (child == 0)
+            {
+                close(pipes[0]);
+                const Result result = run_child(backends[b], &workloads[w], items);
+                const int written = write(pipes[1], &result, sizeof(result)) == sizeof(result);
+                _exit(written ? 0 : 1);
+            }
+
+            close(pipes[1]);
+            Result result;
+            const int received = read(pipes[0], &result, sizeof(result)) == sizeof(result);
+            close(pipes[0]);
+            int status = 0;
+            waitpid(child, &status, 0);
+
+            if (!received || !WIFEXITED(status) || WEXITSTATUS(status) != 0)
+            {
+                fprintf(stderr, "%s/%s failed\n", backends[b], workloads[w].name);
+                continue;
+            }
+            if (result.skipped)
+            {
+                if (w == 0)
+                    fprintf(stderr, "skipping %s: not installed\n", backends[b]);
+                continue;
+            }
+
+            printf("%s\n    {\"allocator\": \"%s\", \"workload\": \"%s\", \"seconds\": %.9f, "
+                "\"ops_per_second\": %.0f, \"live_bytes\": %zu, \"rss_bytes\": %zu, \"fragmentation\": %.3f}",
+                first ? "" : ",", backends[b], workloads[w].name, result.seconds,
+                (double)result.ops / result.seconds, result.live_bytes, result.resident_bytes,
+                result.live_bytes ? (double)result.resident_bytes / (double)result.live_bytes : 0.0);
+            first = 0;
+        }
+    }
+    printf("\n  ]\n}\n");
+    return 0;
+}
@@ -10,6 +10,19 @@
     Optionally provide the following defines with your own implementations
 
         DEFAULT_LIST_CAPACITY       - starting capacity allocated for new lists (default: 16)
+        DYNAMIC_LIST_DIRTY_TRACKING - track which blocks of a list changed, for incremental checkpoints
+        DYNAMIC_LIST_DIRTY_BLOCK    - size in bytes of a dirty-tracked block (default: 4096)
+        DYNAMIC_LIST_DIFF_BLOCK     - size in bytes of the blocks matched by list_diff (default: 1024)
+        DYNAMIC_LIST_WIRE_BLOCK     - size in bytes of a checksummed block in the wire format (default: 65536)
+        DYNAMIC_LIST_USDT           - add USDT probes on list creation, growth and free (needs <sys/sdt.h>)
+        DYNAMIC_LIST_ACCOUNTING     - count the live lists and bytes of each allocator, for list_allocator_stats
+        DYNAMIC_LIST_TRACK_SITES    - record where each list was created, for list_site_report
+        DYNAMIC_LIST_ADAPTIVE_CAPACITY - let each list_new call site learn its starting capacity
+        DYNAMIC_LIST_ADAPTIVE_SAMPLES  - lists freed from a site before its capacity adapts (default: 16)
+        DYNAMIC_LIST_LATENCY        - record growth and bulk operation latency in per-thread histograms
+        DYNAMIC_LIST_LATENCY_SUB_BITS  - log2 of the linear steps per power of two in a histogram (default: 4)
+        DYNAMIC_LIST_NO_ANNOTATIONS - don't poison spare capacity in AddressSanitizer builds
+        DYNAMIC_LIST_POOL_CHUNK     - most objects in one chunk of a ListPool (default: 4096)
 
     If you're compiling in MSVC, Visual Studio, or Rider, you may need to define this project-wide:
 
@@ -63,6 +76,34 @@
             list_int list = list_new(int);
 
 
+    Static Lists
+    ============
+    When the most items a list will ever hold is known, its storage can live inline - on the stack,
+    in a struct, or in static memory - with no allocator involved:
+
+            list_static(int, 64) list;
+            list_static_init(list);
+
+            if (!list_static_append(list, 10))
+                puts("full");
+            list_static_remove_at(list, 0);
+
+            for (size_t i = 0; i < list_static_len(list); i++)
+                printf("%d\n", list.items[i]);
+
+        list_static_append returns a pointer to the new item, or NULL when the list is full.
+        list_static_cap is a constant expression, so the compiler sees the bound and can drop the
+        check when it knows the length. list_static_clear, list_static_pop_back and
+        list_static_remove_at (which moves the last item into the gap, like list_remove_at) work as
+        their heap counterparts do.
+
+        list.items is laid out like a heap list, so it can be passed to anything that only reads a
+        list: list_len, list_hash64, list_equal, list_wire_encode, list_save_npy... it must never be
+        passed to something that grows or frees a list, such as list_append or list_free. item types
+        aligned beyond max_align_t aren't supported. these macros are C only; C++ has
+        dynamic_list::static_list in dynamic_list.hpp.
+
+
     Allocators
     ==========
     The default allocator uses the standard C lib `malloc`, `realloc`, and `free`.
@@ -87,6 +128,385 @@
     The context pointer passed to the Allocator struct is for custom allocator state. Whenever any
     of the allocator functions are called, the context pointer is passed to the function.
 
+    --- to see how much memory a list takes:
+
+            size_t used = list_bytes_used(list);         // prelude + length * stride
+            size_t reserved = list_bytes_reserved(list); // prelude + capacity * stride
+
+    --- to see how much memory all lists of an allocator take:
+
+            ListAllocatorStats stats = list_allocator_stats(&allocator);
+
+        this returns the number of live lists, the bytes they have reserved, and the most bytes
+        reserved at once since the allocator was made or since list_allocator_reset_peak. the
+        counters live in the Allocator struct, are updated with relaxed atomics on creation, growth
+        and free, and start at zero. pass NULL for the default allocator.
+
+        the counters are only kept when DYNAMIC_LIST_ACCOUNTING is defined, and stay at zero
+        otherwise, since every list of the default allocator updates the same cache line.
+
+    --- to grow a list whose items can't be moved with memcpy:
+
+            list = list_ensure_capacity_relocate(list, 1, sizeof(Item), relocate_items);
+
+        instead of calling realloc, this allocates the new block, calls relocate_items to move the
+        items into it, and frees the old block. if the new block can't be allocated, it returns NULL
+        and leaves the list as it was. this is what dynamic_list::emplace_back in dynamic_list.hpp
+        uses for C++ types that aren't trivially relocatable, where that throws std::bad_alloc.
+
+
+    Object Pools
+    ============
+    --- to allocate many objects of one size without a malloc each:
+
+            ListPool pool;
+            list_pool_init(&pool, Node, &allocator);
+
+            Node* node = list_pool_alloc(&pool);
+            list_pool_free(&pool, node);
+
+            list_pool_destroy(&pool);
+
+        objects are carved from chunks, which are lists of slots made with the pool's allocator
+        (NULL for the default one). the first chunk has DEFAULT_LIST_CAPACITY slots, every new chunk
+        has twice as many as the last, up to DYNAMIC_LIST_POOL_CHUNK. chunks never grow, so objects
+        never move. a freed slot stores the address of the next vacant one, and is handed out again
+        before any new slot, so list_pool_alloc and list_pool_free are O(1). slots are at least a
+        pointer wide, and aligned like the objects. list_pool_init returns 0 on success and -1 when
+        the chunk list can't be allocated, and list_pool_alloc returns NULL when a chunk can't be.
+
+    --- to free every object at once:
+
+            list_pool_clear(&pool);
+
+        this keeps the chunks for the next objects. list_pool_destroy frees the chunks too. neither
+        runs any code for the objects still live, which can be counted with pool.live.
+
+        a pool is not thread safe. under AddressSanitizer, freed objects are poisoned until they are
+        handed out again.
+
+
+    Batches
+    =======
+    --- to make many small lists with one allocation:
+
+            int* buckets[256];
+            if (list_new_batch(int, buckets, 256, 8, &allocator) != 0)
+                // out of memory
+
+        this carves 256 lists with room for 8 items each out of one block from the allocator (NULL
+        for the default one), laid out one after another. it returns 0 on success and -1 if the
+        block can't be allocated. the lists are used and freed like any other. a list that outgrows its slot moves
+        to a block of its own from the same allocator, and the batch's block is freed along with
+        the last list still in it. create_lists_batch does the same for a stride known at runtime:
+
+            create_lists_batch(count, stride, capacity, allocator, lists);
+
+        the lists are accounted to the allocator as if each had been made alone, and with
+        DYNAMIC_LIST_TRACK_SITES they're recorded under the list_new_batch call. the block's other
+        bytes - a header, and padding that keeps every slot aligned like max_align_t - aren't counted.
+        lists in a batch can be freed from different threads.
+
+
+    Incremental Checkpoints
+    =======================
+    With DYNAMIC_LIST_DIRTY_TRACKING defined, a list can record which blocks of its items were
+    written since the last checkpoint:
+
+            list_track_dirty(list);
+
+        list_append, list_resize, list_remove_at and list_set mark the blocks they write. writes made
+        directly through the pointer must be marked by hand:
+
+            list[3] = 42;
+            list_mark_dirty(list, 3, 1);
+
+            list_set(list, 3, 42); // same as above
+
+    --- to write a checkpoint:
+
+            list_checkpoint_delta(list, fd);
+
+        this writes only the blocks changed since the previous checkpoint (or every block, the first
+        time), then clears the dirty bits. the record format, in native byte order, is:
+
+            u64 magic ("DLPCK1"), u64 stride, u64 length, u64 block size
+            { u64 block index, u64 byte count, bytes... } for each dirty block
+            u64 ~0, u64 0
+
+        the length in the header lets a reader truncate its copy after removes or clears.
+
+
+    Hashing and Equality
+    ====================
+    --- to hash the items of a list:
+
+            unsigned long long hash = list_hash64(list);
+            ListHash128 wide = list_hash128(list);
+
+        this hashes the raw bytes of the items, in native byte order, with SSE2 or AVX2 when the
+        compiler targets them. the scalar, SSE2 and AVX2 paths always produce the same hash.
+
+    --- to compare two lists:
+
+            if (list_equal(a, b)) ...
+
+        lists are equal when they have the same stride, the same length, and the same bytes.
+
+    --- to keep a hash up to date while appending:
+
+            ListHashState state;
+            list_hash_init(&state, 0);
+
+            list_append(list, 10);
+            list_hash_sync(&state, list);
+            unsigned long long hash = list_hash_digest(&state); // same as list_hash64(list)
+
+        list_hash_sync only hashes items appended since the previous sync. it returns -1 if the list
+        got shorter, since earlier items can't be un-hashed; start over with list_hash_init then.
+        list_hash_update hashes arbitrary bytes into the same state.
+
+
+    Apache Arrow
+    ============
+    --- to hand a list to an Arrow consumer without copying:
+
+            struct ArrowArray array;
+            struct ArrowSchema schema;
+            list_to_arrow_array(list, "i", &array, &schema);
+
+        the format must be a primitive Arrow format whose width matches the list's stride ("c", "C",
+        "s", "S", "e", "i", "I", "f", "l", "L" or "g"), otherwise -1 is returned. the array takes
+        ownership of the list: its data buffer is the list's own memory, and releasing the array
+        frees the list. do not use or free the list afterwards.
+
+    --- to take an Arrow array as a list:
+
+            int* list = list_from_arrow_array(&array, &schema, NULL);
+
+        this takes ownership of the array and releases it. an array that came from
+        list_to_arrow_array is handed back as the original list without copying; any other array is
+        copied into a new list from the given allocator. arrays with nulls are rejected and return
+        NULL. the schema is left for the caller to release.
+
+
+    Parsing Text
+    ============
+    --- to append numbers parsed from text:
+
+            long long* ints = list_new(long long);
+            list_parse_ints(ints, text, text_size, ',');
+
+            double* floats = list_new(double);
+            list_parse_floats(floats, text, text_size, ',');
+
+        numbers are split by the separator or by newlines, with blanks around them ignored and empty
+        fields skipped. ints may be 1, 2, 4 or 8 byte signed types; floats may be float or double.
+        the separators are counted up front with SSE2, so the list grows at most once per call.
+
+        parsing stops at the first field that isn't a number or doesn't fit the item type. to find
+        out where, call the function form, which also reports how many bytes were consumed:
+
+            size_t consumed;
+            ints = list_parse_ints_into(ints, sizeof(long long), text, text_size, ',', &consumed);
+
+
+    NumPy
+    =====
+    --- to save a list as a .npy file:
+
+            list_save_npy(list, "values.npy", "<f8");
+
+        the dtype must be a numpy dtype string whose size matches the list's stride and whose byte
+        order matches the host. the list is saved as a 1 dimensional array.
+
+    --- to load a .npy file:
+
+            double* list = list_load_npy(double, "values.npy", "<f8");
+
+        this returns NULL if the file's dtype differs from the one given, or its size doesn't match
+        the item type. pass NULL as the dtype to accept any dtype of the right size and byte order.
+        arrays with more than one dimension are loaded flat, in C order.
+
+    --- to map a .npy file instead of reading it:
+
+            double* list = list_map_npy(double, "values.npy", "<f8");
+
+        the items are used in place from a private mapping of the file, so loading costs no copy and
+        pages are read on demand. the list's prelude is written over the end of the file's header in
+        that mapping; writes made through the list are never written back to the file. appending to
+        a mapped list moves it to the heap. on Windows, or when the header leaves no room for a
+        prelude, the file is read as with list_load_npy.
+
+
+    Wire Format
+    ===========
+    --- to encode a list for another host:
+
+            unsigned char* bytes = list_wire_encode(list, LIST_WIRE_INT, LIST_WIRE_CHECKSUMS, NULL);
+            send(socket, bytes, list_len(bytes), 0);
+
+        the kind is one of LIST_WIRE_RAW, LIST_WIRE_INT, LIST_WIRE_UINT or LIST_WIRE_FLOAT. the header
+        records the stride, the kind, and the writer's byte order; the items are copied as they are.
+        with LIST_WIRE_CHECKSUMS, a 64 bit hash follows every DYNAMIC_LIST_WIRE_BLOCK bytes of items.
+
+    --- to decode it:
+
+            int* list = list_wire_decode(int, bytes, size);
+
+        this returns NULL if the header is invalid, the stride doesn't match the item type, or a
+        checksum doesn't match. numbers written on a host with the other byte order are swapped after
+        copying; raw items are never swapped. when the byte orders match, decoding is a single copy.
+
+        list_byte_swap(items, count, stride) is the swap kernel on its own. it uses SSSE3 or AVX2
+        shuffles when the compiler targets them.
+
+
+    Diff and Patch
+    ==============
+    --- to describe how to turn one list into another:
+
+            unsigned char* script = list_diff(old_list, new_list);
+
+        the script is a byte list holding copies of whole blocks of `old_list` plus literal items that
+        aren't found in it. blocks are found at any item offset using a rolling hash, so items
+        inserted or removed in the middle only cost the items themselves. both lists must share the
+        same stride.
+
+    --- to rebuild the new list from the old one:
+
+            int* rebuilt = list_patch(old_list, script);
+
+        this returns NULL if the script is malformed or was made for a different stride. both
+        list_diff_alloc and list_patch_alloc take an allocator for the returned list.
+
+
+    Tracing
+    =======
+    With DYNAMIC_LIST_USDT defined in the C file holding the implementation, USDT probes are placed in
+    the `dynamic_list` provider. the probes come from <sys/sdt.h> (systemtap-sdt-dev on Debian,
+    systemtap-sdt-devel on Fedora), which only adds a nop and an ELF note at each site; there is no
+    library to link and no cost until a tracer attaches.
+
+        create(list, capacity, stride, bytes)
+        grow(old_list, new_list, old_capacity, new_capacity, stride, bytes)
+        free(list, capacity, stride, bytes)
+
+    bytes is the size of the whole allocation, prelude included. to find the call stacks causing the
+    most reallocation in a running process:
+
+            bpftrace -e 'usdt:/path/to/app:dynamic_list:grow { @[ustack] = sum(arg5); }' -p $PID
+
+
+    Allocation Sites
+    ================
+    With DYNAMIC_LIST_TRACK_SITES defined everywhere the header is included, list_new and
+    list_new_alloc record the file and line they were called from, and every live list is kept in a
+    registry grouped by that site. a tag can be given instead of relying on the line:
+
+            int* list = list_new_tagged(int, NULL, "request buffers");
+
+    --- to print live lists grouped by site, most wasted capacity first:
+
+            list_site_report(stderr);
+
+        this prints, for each site, how many lists are alive and their total length, capacity, bytes
+        reserved, and slack bytes (capacity allocated beyond the length). lists made with
+        create_list are grouped under "(unknown)".
+
+    --- to read the same numbers programmatically:
+
+            ListSiteStats stats[64];
+            size_t count = list_site_stats(stats, 64);
+
+        this returns the number of sites with live lists, which may exceed the number filled in.
+
+        the registry is locked on creation, growth and free. totals read while other threads append
+        are approximate.
+
+    Adaptive Capacity
+    =================
+    With DYNAMIC_LIST_ADAPTIVE_CAPACITY defined everywhere the header is included, each list_new,
+    list_new_alloc and list_new_tagged call site keeps a histogram of the lengths its lists had when
+    they were freed. once DYNAMIC_LIST_ADAPTIVE_SAMPLES lists have been freed, new lists from that
+    site start with the power of two capacity that would have held 90% of them, instead of
+    DEFAULT_LIST_CAPACITY. the histogram is halved now and then, so a site follows changes in its
+    workload.
+
+        lists made with create_list keep the capacity they ask for.
+
+
+    Latency
+    =======
+    With DYNAMIC_LIST_LATENCY defined everywhere the header is included, every growth in
+    list_ensure_capacity and every call to the bulk operations - list_parse_ints, list_parse_floats,
+    list_diff, list_patch, list_wire_encode, list_wire_decode and list_external_sort - is timed with
+    the cycle counter (rdtsc on x86, cntvct_el0 on arm64, timespec_get elsewhere) and recorded in a
+    histogram owned by the calling thread. buckets are log-linear, so percentiles are exact to
+    within 1/16 of their value however long the tail is.
+
+    --- to print the calling thread's percentiles in nanoseconds:
+
+            ListLatencyHistogram histograms[LIST_LATENCY_EVENTS];
+            list_latency_snapshot(histograms);
+            list_latency_dump(stderr, histograms);
+
+    --- to combine threads, each one snapshots its own histograms and they are merged:
+
+            for (int event = 0; event < LIST_LATENCY_EVENTS; event++)
+                list_latency_merge(&totals[event], &histograms[event]);
+
+        list_latency_reset clears the calling thread's histograms, list_latency_percentile reads a
+        percentile in ticks, and list_latency_tick_ns measures how long a tick is (this spins for
+        about 10ms). the histograms are about 8KB per event per thread.
+
+
+    Sanitizers
+    ==========
+    When compiled with AddressSanitizer (-fsanitize=address), the capacity beyond a list's length is
+    poisoned with __sanitizer_annotate_contiguous_container, and kept in sync by list_append,
+    list_resize, list_remove_at, list_pop_back, list_clear, growth, and the functions that fill a
+    list. reading or writing past the length is then reported as a container-overflow, even though
+    the memory is allocated. other builds compile the annotations out entirely.
+
+        every file using the list macros has to be built with the sanitizer, or with
+        DYNAMIC_LIST_NO_ANNOTATIONS defined. code that grows list_len by hand instead of using
+        list_resize will see its new items reported as overflows.
+
+
+    Sorting
+    =======
+    --- to sort a list in memory:
+
+            int compare_ints(const void* a, const void* b);
+            list_sort(list, compare_ints);
+
+    --- to sort more items than fit in memory:
+
+            FILE* in = fopen("items.bin", "rb");
+            FILE* out = fopen("sorted.bin", "wb");
+            list_external_sort(in, out, sizeof(int), 1 << 20, compare_ints, NULL);
+
+        `in` is read as raw items of the given stride. runs of up to `run_capacity` items are
+        sorted in memory, spilled to temporary files, then k-way merged into `out`. whenever
+        DYNAMIC_LIST_MERGE_FANIN runs of the same size are spilled they are merged into one, so the
+        number of open files grows with the log of the input. while merging, each run is read
+        through two buffers: one is consumed while the other is refilled by a background io thread.
+
+        list_external_sort_stream does the same, but hands sorted items to a callback instead of a
+        file:
+
+            int sink(const void* items, size_t count, void* context);
+            list_external_sort_stream(in, sizeof(int), 1 << 20, compare_ints, sink, NULL, NULL);
+
+        both return 0 on success and -1 if reading, writing, or allocating fails, or if the sink
+        returns non-zero.
+
+        Optionally provide the following defines:
+
+            DYNAMIC_LIST_MERGE_FANIN    - max runs merged at once, more runs are merged in passes (default: 64)
+            DYNAMIC_LIST_NO_THREADS     - refill merge buffers synchronously instead of using C11 threads
+
     License
     =======
     Copyright 2024 dresswithpockets (dresswithpockets@pm.me)
@@ -107,8 +527,11 @@
 #pragma once
 
 #include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
 
-#ifdef DYNAMIC_LIST_DEF_MAXALIGN
+#if defined(DYNAMIC_LIST_DEF_MAXALIGN) && !defined(__cplusplus)
 // this definition of max_align_t is only really necessary when using MSVC, since max_align_t isnt
 // included in stddef.h on some versions of the Windows SDK for some ungodly reason, even in newer C
 // standards
@@ -121,40 +544,179 @@ typedef struct {
 } max_align_t;
 #endif
 
+// the declarations and macros can be used from C++; the implementation is always compiled as C
+#ifdef __cplusplus
+#include <type_traits>
+#define list_internal_alignas(T) alignas(T)
+// decltype of anything but a plain name, like *pp or buckets[i], is a reference type
+#define list_internal_cast(list) (typename std::remove_reference<decltype(list)>::type)
+#else
+#define list_internal_alignas(T) _Alignas(T)
+#define list_internal_cast(list)
+#endif
+
 #ifndef DEFAULT_LIST_CAPACITY
 #define DEFAULT_LIST_CAPACITY 16
 #endif
 
+#ifndef DYNAMIC_LIST_DIRTY_BLOCK
+#define DYNAMIC_LIST_DIRTY_BLOCK 4096
+#endif
+
+#ifndef DYNAMIC_LIST_DIFF_BLOCK
+#define DYNAMIC_LIST_DIFF_BLOCK 1024
+#endif
+
+#if defined(DYNAMIC_LIST_TRACK_SITES) || defined(DYNAMIC_LIST_ADAPTIVE_CAPACITY)
+#define DYNAMIC_LIST_SITES
+#endif
+
+#ifndef DYNAMIC_LIST_ADAPTIVE_SAMPLES
+#define DYNAMIC_LIST_ADAPTIVE_SAMPLES 16
+#endif
+
+#ifndef DYNAMIC_LIST_LATENCY_SUB_BITS
+#define DYNAMIC_LIST_LATENCY_SUB_BITS 4
+#endif
+
+#ifndef DYNAMIC_LIST_POOL_CHUNK
+#define DYNAMIC_LIST_POOL_CHUNK 4096
+#endif
+
+#ifdef DYNAMIC_LIST_DIRTY_TRACKING
+#define list_internal_mark_dirty(list, first, count) list_mark_dirty(list, first, count)
+#else
+#define list_internal_mark_dirty(list, first, count) ((void)0)
+#endif
+
+#if !defined(DYNAMIC_LIST_NO_ANNOTATIONS) && !defined(DYNAMIC_LIST_ANNOTATE)
+#if defined(__SANITIZE_ADDRESS__)
+#define DYNAMIC_LIST_ANNOTATE
+#elif defined(__has_feature)
+#if __has_feature(address_sanitizer)
+#define DYNAMIC_LIST_ANNOTATE
+#endif
+#endif
+#endif
+
+// keeps [length, capacity) poisoned under AddressSanitizer, so writes past the length are caught
+// even though the memory is allocated
+#ifdef DYNAMIC_LIST_ANNOTATE
+#include <sanitizer/asan_interface.h>
+#include <sanitizer/common_interface_defs.h>
+#define list_internal_annotate(list, old_length, new_length) __sanitizer_annotate_contiguous_container( \
+    (list), \
+    (const char*)(list) + list_prelude(list)->capacity * list_prelude(list)->stride, \
+    (const char*)(list) + (old_length) * list_prelude(list)->stride, \
+    (const char*)(list) + (new_length) * list_prelude(list)->stride)
+#define list_internal_poison(ptr, size) __asan_poison_memory_region(ptr, size)
+#define list_internal_unpoison(ptr, size) __asan_unpoison_memory_region(ptr, size)
+#else
+#define list_internal_annotate(list, old_length, new_length) ((void)0)
+#define list_internal_poison(ptr, size) ((void)0)
+#define list_internal_unpoison(ptr, size) ((void)0)
+#endif
+
 
 
 #define list_type(T) typedef T* list_##T
 #define list_prelude(list) ((ListPrelude*)(list)-1)
+#if defined(DYNAMIC_LIST_TRACK_SITES) || defined(DYNAMIC_LIST_ADAPTIVE_CAPACITY)
+#define list_new(T) ((T*)create_list_at(sizeof(T), DEFAULT_LIST_CAPACITY, NULL, __FILE__, __LINE__, NULL))
+#define list_new_alloc(T, allocator) ((T*)create_list_at(sizeof(T), DEFAULT_LIST_CAPACITY, allocator, __FILE__, __LINE__, NULL))
+#else
 #define list_new(T) ((T*)create_list(sizeof(T), DEFAULT_LIST_CAPACITY, NULL))
 #define list_new_alloc(T, allocator) ((T*)create_list(sizeof(T), DEFAULT_LIST_CAPACITY, allocator))
-#define list_free(list) list_prelude(list)->allocator->free(list_prelude(list), list_prelude(list)->allocator->context)
+#endif
+#define list_new_tagged(T, allocator, tag) ((T*)create_list_at(sizeof(T), DEFAULT_LIST_CAPACITY, allocator, __FILE__, __LINE__, tag))
+#ifdef DYNAMIC_LIST_SITES
+#define list_new_batch(T, lists, count, capacity, allocator) \
+    create_lists_batch_at(count, sizeof(T), capacity, allocator, lists, __FILE__, __LINE__, NULL)
+#else
+#define list_new_batch(T, lists, count, capacity, allocator) create_lists_batch(count, sizeof(T), capacity, allocator, lists)
+#endif
+#define list_free(list) destroy_list(list)
 #define list_len(list) (list_prelude(list)->length)
 #define list_cap(list) (list_prelude(list)->capacity)
-#define list_clear(list) (list_prelude(list)->length = 0)
+#define list_clear(list) ( \
+    list_internal_annotate(list, list_prelude(list)->length, 0), \
+    list_prelude(list)->length = 0)
 #define list_resize(list, desired) ( \
-    (list) = list_ensure_capacity(list, desired, sizeof(*(list))), \
+    (list) = list_internal_cast(list)list_ensure_capacity(list, desired, sizeof(*(list))), \
+    list_internal_annotate(list, list_prelude(list)->length, list_prelude(list)->length + (desired)), \
+    list_internal_mark_dirty(list, list_prelude(list)->length, desired), \
     &(list)[list_prelude(list)->length += (desired)])
 #define list_append(list, item) ( \
-    (list) = list_ensure_capacity(list, 1, sizeof(item)), \
+    (list) = list_internal_cast(list)list_ensure_capacity(list, 1, sizeof(item)), \
+    list_internal_annotate(list, list_prelude(list)->length, list_prelude(list)->length + 1), \
     (list)[list_prelude(list)->length] = (item), \
+    list_internal_mark_dirty(list, list_prelude(list)->length, 1), \
     &(list)[list_prelude(list)->length++])
+#define list_set(list, index, item) ( \
+    list_internal_mark_dirty(list, index, 1), \
+    (list)[index] = (item))
 #define list_remove_at(list, index) do { \
     ListPrelude *h = list_prelude(list); \
     if ((index) == h->length - 1) { \
         h->length -= 1; \
+        list_internal_annotate(list, h->length + 1, h->length); \
     } else if (h->length > 1) { \
         void *ptr = &(list)[index]; \
         void *last = &(list)[h->length - 1]; \
-        h->length -= 1; \
         memcpy(ptr, last, sizeof(*(list))); \
+        h->length -= 1; \
+        list_internal_annotate(list, h->length + 1, h->length); \
+        list_internal_mark_dirty(list, index, 1); \
+    } \
+} while (0)
+
+#define list_diff(a, b) create_list_diff(a, b, DYNAMIC_LIST_DIFF_BLOCK, NULL)
+#define list_diff_alloc(a, b, allocator) create_list_diff(a, b, DYNAMIC_LIST_DIFF_BLOCK, allocator)
+#define list_patch(a, script) create_list_patch(a, script, NULL)
+#define list_patch_alloc(a, script, allocator) create_list_patch(a, script, allocator)
+
+#define list_load_npy(T, path, descr) ((T*)create_list_from_npy(path, descr, sizeof(T), NULL))
+#define list_load_npy_alloc(T, path, descr, allocator) ((T*)create_list_from_npy(path, descr, sizeof(T), allocator))
+#define list_map_npy(T, path, descr) ((T*)create_list_map_npy(path, descr, sizeof(T)))
+
+#define list_parse_ints(list, buffer, size, separator) \
+    ((list) = list_internal_cast(list)list_parse_ints_into(list, sizeof(*(list)), buffer, size, separator, NULL))
+#define list_parse_floats(list, buffer, size, separator) \
+    ((list) = list_internal_cast(list)list_parse_floats_into(list, sizeof(*(list)), buffer, size, separator, NULL))
+
+#define list_wire_decode(T, data, size) ((T*)create_list_from_wire(data, size, sizeof(T), NULL))
+#define list_wire_decode_alloc(T, data, size, allocator) ((T*)create_list_from_wire(data, size, sizeof(T), allocator))
+
+#define list_sort(list, compare) qsort(list, list_len(list), sizeof(*(list)), compare)
+
+#define list_pop_back(list) ( \
+    list_internal_annotate(list, list_prelude(list)->length, list_prelude(list)->length - 1), \
+    list_prelude(list)->length -= 1)
+
+// the prelude sits right before the items, as in a heap list, so .items can be read by any
+// function taking a list
+#define list_static(T, N) struct { ListPrelude prelude; T items[N]; }
+#define list_static_cap(list) (sizeof((list).items) / sizeof((list).items[0]))
+#define list_static_len(list) ((list).prelude.length)
+#define list_static_init(list) ( \
+    (list).prelude = (ListPrelude){.capacity = list_static_cap(list), .stride = sizeof((list).items[0])}, \
+    (list).items)
+#define list_static_clear(list) ((list).prelude.length = 0)
+#define list_static_append(list, item) ( \
+    list_static_len(list) < list_static_cap(list) \
+        ? ((list).items[list_static_len(list)] = (item), &(list).items[list_static_len(list)++]) \
+        : NULL)
+#define list_static_remove_at(list, index) do { \
+    if ((size_t)(index) < list_static_len(list)) { \
+        list_static_len(list) -= 1; \
+        (list).items[index] = (list).items[list_static_len(list)]; \
     } \
 } while (0)
+#define list_static_pop_back(list) ((list).prelude.length -= 1)
 
-#define list_pop_back(a) (array_header(a)->length -= 1)
+#ifdef __cplusplus
+extern "C" {
+#endif
 
 typedef struct
 {
@@ -162,82 +724,3197 @@ typedef struct
     void* (*realloc)(void*, size_t, void*);
     void (*free)(void*, void*);
     void* context;
+
+    // kept up to date by the list functions with DYNAMIC_LIST_ACCOUNTING, read with list_allocator_stats
+    size_t live_lists;
+    size_t live_bytes;
+    size_t peak_bytes;
 } Allocator;
 
 typedef struct
+{
+    size_t live_lists;
+    size_t live_bytes;
+    size_t peak_bytes;
+} ListAllocatorStats;
+
+typedef struct ListSite ListSite;
+
+typedef struct ListPrelude
 {
     size_t capacity;
     size_t length;
-    _Alignas(max_align_t) Allocator* allocator;
+    list_internal_alignas(max_align_t) Allocator* allocator;
+    size_t stride;
+#ifdef DYNAMIC_LIST_DIRTY_TRACKING
+    unsigned char* dirty;
+#endif
+#ifdef DYNAMIC_LIST_SITES
+    ListSite* site;
+#endif
+#ifdef DYNAMIC_LIST_TRACK_SITES
+    struct ListPrelude* site_prev;
+    struct ListPrelude* site_next;
+#endif
 } ListPrelude;
 
+typedef struct
+{
+    const char* file;
+    int line;
+    const char* tag;
+    size_t lists;
+    size_t length;
+    size_t capacity;
+    size_t bytes_used;
+    size_t bytes_reserved;
+} ListSiteStats;
+
+// hands out fixed-size objects from chunks that are lists of slots. a vacant slot holds the
+// address of the next vacant one
+typedef struct
+{
+    Allocator* allocator;
+    size_t size;
+    unsigned char** chunks;
+    size_t current;
+    void* vacant;
+    size_t live;
+} ListPool;
+
+// moves count items from one block to another that doesn't overlap it, leaving the source for
+// the allocator to free
+typedef void (*ListRelocateFn)(void* to, void* from, size_t count);
+
+void* default_allocator_alloc(size_t size, void* context);
+void* default_allocator_realloc(void* ptr, size_t size, void* context);
+void default_allocator_free(void* ptr, void* context);
+
 void* create_list(size_t stride, size_t capacity, Allocator* allocator);
+void* create_list_at(size_t stride, size_t capacity, Allocator* allocator, const char* file, int line, const char* tag);
+int create_lists_batch(size_t count, size_t stride, size_t capacity, Allocator* allocator, void* lists);
+int create_lists_batch_at(size_t count, size_t stride, size_t capacity, Allocator* allocator, void* lists,
+    const char* file, int line, const char* tag);
+void destroy_list(void* list);
 void* list_ensure_capacity(void *list, size_t item_count, size_t item_size);
+void* list_ensure_capacity_relocate(void *list, size_t item_count, size_t item_size, ListRelocateFn relocate);
+size_t list_bytes_used(const void* list);
+size_t list_bytes_reserved(const void* list);
+ListAllocatorStats list_allocator_stats(const Allocator* allocator);
+void list_allocator_reset_peak(Allocator* allocator);
 
-#ifdef DYNAMIC_LIST_IMPL
+#define list_pool_init(pool, T, allocator) list_pool_init_size(pool, sizeof(T), allocator)
+int list_pool_init_size(ListPool* pool, size_t size, Allocator* allocator);
+void* list_pool_alloc(ListPool* pool);
+void list_pool_free(ListPool* pool, void* object);
+void list_pool_clear(ListPool* pool);
+void list_pool_destroy(ListPool* pool);
 
-#include <stdlib.h>
+#ifdef DYNAMIC_LIST_TRACK_SITES
+size_t list_site_stats(ListSiteStats* stats, size_t max);
+void list_site_report(FILE* out);
+#endif
 
-void* default_allocator_alloc(const size_t size, void* context)
+#ifdef DYNAMIC_LIST_LATENCY
+enum
 {
-    (void)context;
-    return malloc(size);
-}
+    LIST_LATENCY_GROW,
+    LIST_LATENCY_PARSE,
+    LIST_LATENCY_DIFF,
+    LIST_LATENCY_PATCH,
+    LIST_LATENCY_WIRE_ENCODE,
+    LIST_LATENCY_WIRE_DECODE,
+    LIST_LATENCY_SORT,
+    LIST_LATENCY_EVENTS,
+};
 
-void* default_allocator_realloc(void* ptr, const size_t size, void* context)
+#define LIST_LATENCY_SUB (1 << DYNAMIC_LIST_LATENCY_SUB_BITS)
+#define LIST_LATENCY_BUCKETS ((65 - DYNAMIC_LIST_LATENCY_SUB_BITS) * LIST_LATENCY_SUB)
+
+typedef struct
 {
-    (void)context;
-    return realloc(ptr, size);
-}
+    unsigned long long counts[LIST_LATENCY_BUCKETS];
+    unsigned long long total;
+    unsigned long long sum;
+    unsigned long long min;
+    unsigned long long max;
+} ListLatencyHistogram;
 
-void default_allocator_free(void* ptr, void* context)
+unsigned long long list_latency_ticks(void);
+double list_latency_tick_ns(void);
+void list_latency_record(int event, unsigned long long ticks);
+void list_latency_snapshot(ListLatencyHistogram* histograms);
+void list_latency_reset(void);
+void list_latency_merge(ListLatencyHistogram* into, const ListLatencyHistogram* from);
+unsigned long long list_latency_percentile(const ListLatencyHistogram* histogram, double percentile);
+void list_latency_dump(FILE* out, const ListLatencyHistogram* histograms);
+#endif
+
+typedef struct
 {
-    (void)context;
-    free(ptr);
-}
+    unsigned long long low;
+    unsigned long long high;
+} ListHash128;
 
-static Allocator default_allocator = {
-    .alloc = default_allocator_alloc,
-    .realloc = default_allocator_realloc,
-    .free = default_allocator_free,
-    .context = NULL,
+typedef struct
+{
+    unsigned long long accumulators[8];
+    unsigned char buffer[64];
+    size_t buffered;
+    size_t stripe;
+    unsigned long long total;
+    unsigned long long seed;
+    size_t consumed;
+} ListHashState;
+
+unsigned long long list_hash64(const void* list);
+ListHash128 list_hash128(const void* list);
+int list_equal(const void* a, const void* b);
+void list_hash_init(ListHashState* state, unsigned long long seed);
+void list_hash_update(ListHashState* state, const void* data, size_t size);
+int list_hash_sync(ListHashState* state, const void* list);
+unsigned long long list_hash_digest(const ListHashState* state);
+ListHash128 list_hash_digest128(const ListHashState* state);
+
+#ifndef ARROW_C_DATA_INTERFACE
+#define ARROW_C_DATA_INTERFACE
+
+#define ARROW_FLAG_DICTIONARY_ORDERED 1
+#define ARROW_FLAG_NULLABLE 2
+#define ARROW_FLAG_MAP_KEYS_SORTED 4
+
+struct ArrowSchema
+{
+    const char* format;
+    const char* name;
+    const char* metadata;
+    int64_t flags;
+    int64_t n_children;
+    struct ArrowSchema** children;
+    struct ArrowSchema* dictionary;
+    void (*release)(struct ArrowSchema*);
+    void* private_data;
 };
 
-void* create_list(const size_t stride, const size_t capacity, Allocator* allocator)
+struct ArrowArray
 {
-    if (allocator == NULL)
-        allocator = &default_allocator;
+    int64_t length;
+    int64_t null_count;
+    int64_t offset;
+    int64_t n_buffers;
+    int64_t n_children;
+    const void** buffers;
+    struct ArrowArray** children;
+    struct ArrowArray* dictionary;
+    void (*release)(struct ArrowArray*);
+    void* private_data;
+};
 
-    void* result = NULL;
-    ListPrelude* prelude = allocator->alloc(sizeof(ListPrelude) + stride * capacity, allocator->context);
+#endif
 
-    if (prelude)
-    {
-        prelude->capacity = capacity;
-        prelude->length = 0;
-        prelude->allocator = allocator;
-        result = prelude + 1;
-    }
+int list_to_arrow_array(void* list, const char* format, struct ArrowArray* array, struct ArrowSchema* schema);
+void* list_from_arrow_array(struct ArrowArray* array, const struct ArrowSchema* schema, Allocator* allocator);
 
-    return result;
-}
+void* list_parse_ints_into(void* list, size_t stride, const char* buffer, size_t size, char separator, size_t* consumed);
+void* list_parse_floats_into(void* list, size_t stride, const char* buffer, size_t size, char separator, size_t* consumed);
 
-void* list_ensure_capacity(void *list, const size_t item_count, const size_t item_size) {
-    ListPrelude* prelude = list_prelude(list);
-    const size_t desired_capacity = prelude->length + item_count;
+int list_save_npy(const void* list, const char* path, const char* descr);
+void* create_list_from_npy(const char* path, const char* descr, size_t stride, Allocator* allocator);
+void* create_list_map_npy(const char* path, const char* descr, size_t stride);
 
-    if (prelude->capacity < desired_capacity) {
-        size_t new_capacity = prelude->capacity * 2;
-        while (new_capacity < desired_capacity) {
-            new_capacity *= 2;
-        }
+enum
+{
+    LIST_WIRE_RAW,
+    LIST_WIRE_INT,
+    LIST_WIRE_UINT,
+    LIST_WIRE_FLOAT,
+};
 
-        const size_t new_size = sizeof(ListPrelude) + new_capacity * item_size;
-        prelude = prelude->allocator->realloc(prelude, new_size, prelude->allocator->context);
-        prelude->capacity = new_capacity;
-    }
+#define LIST_WIRE_CHECKSUMS 1
 
-    return prelude + 1;
+unsigned char* list_wire_encode(const void* list, int kind, int flags, Allocator* allocator);
+void* create_list_from_wire(const unsigned char* data, size_t size, size_t stride, Allocator* allocator);
+void list_byte_swap(void* items, size_t count, size_t stride);
+
+unsigned char* create_list_diff(const void* a, const void* b, size_t block_size, Allocator* allocator);
+void* create_list_patch(const void* a, const unsigned char* script, Allocator* allocator);
+
+#ifdef DYNAMIC_LIST_DIRTY_TRACKING
+int list_track_dirty(void* list);
+void list_mark_dirty(void* list, size_t first, size_t count);
+int list_checkpoint_delta(void* list, int fd);
+#endif
+
+typedef int (*ListCompareFn)(const void*, const void*);
+typedef int (*ListSinkFn)(const void* items, size_t count, void* context);
+
+int list_external_sort(FILE* in, FILE* out, size_t stride, size_t run_capacity, ListCompareFn compare, Allocator* allocator);
+int list_external_sort_stream(FILE* in, size_t stride, size_t run_capacity, ListCompareFn compare, ListSinkFn sink, void* context, Allocator* allocator);
+
+#ifdef __cplusplus
 }
+#endif
+
+#ifdef DYNAMIC_LIST_IMPL
+
+#ifdef __cplusplus
+#error "define DYNAMIC_LIST_IMPL in a C file; the implementation can't be compiled as C++"
+#endif
+
+#include <errno.h>
+#include <string.h>
+
+#ifdef DYNAMIC_LIST_USDT
+#include <sys/sdt.h>
+#define list_internal_probe_create(list, capacity, stride, bytes) \
+    STAP_PROBE4(dynamic_list, create, list, capacity, stride, bytes)
+#define list_internal_probe_grow(old_list, new_list, old_capacity, new_capacity, stride, bytes) \
+    STAP_PROBE6(dynamic_list, grow, old_list, new_list, old_capacity, new_capacity, stride, bytes)
+#define list_internal_probe_free(list, capacity, stride, bytes) \
+    STAP_PROBE4(dynamic_list, free, list, capacity, stride, bytes)
+#else
+#define list_internal_probe_create(list, capacity, stride, bytes) ((void)0)
+#define list_internal_probe_grow(old_list, new_list, old_capacity, new_capacity, stride, bytes) ((void)0)
+#define list_internal_probe_free(list, capacity, stride, bytes) ((void)0)
+#endif
+
+#ifdef DYNAMIC_LIST_LATENCY
+
+#include <time.h>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#define list_internal_rdtsc() __rdtsc()
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define list_internal_rdtsc() __rdtsc()
+#endif
+
+#define list_internal_latency_begin(name) const unsigned long long name = list_latency_ticks()
+#define list_internal_latency_end(event, name) list_latency_record(event, list_latency_ticks() - (name))
+
+static _Thread_local ListLatencyHistogram list_latency_histograms[LIST_LATENCY_EVENTS];
+
+static const char* const list_latency_names[LIST_LATENCY_EVENTS] = {
+    "grow",
+    "parse",
+    "diff",
+    "patch",
+    "wire_encode",
+    "wire_decode",
+    "sort",
+};
+
+unsigned long long list_latency_ticks(void)
+{
+#ifdef list_internal_rdtsc
+    return list_internal_rdtsc();
+#elif defined(__aarch64__) && (defined(__GNUC__) || defined(__clang__))
+    unsigned long long ticks;
+    __asm__ __volatile__("mrs %0, cntvct_el0" : "=r"(ticks));
+    return ticks;
+#else
+    struct timespec now;
+    timespec_get(&now, TIME_UTC);
+    return (unsigned long long)now.tv_sec * 1000000000ull + (unsigned long long)now.tv_nsec;
+#endif
+}
+
+double list_latency_tick_ns(void)
+{
+    struct timespec start, now;
+    timespec_get(&start, TIME_UTC);
+    const unsigned long long first = list_latency_ticks();
+
+    long long elapsed;
+    do
+    {
+        timespec_get(&now, TIME_UTC);
+        elapsed = (long long)(now.tv_sec - start.tv_sec) * 1000000000ll + (now.tv_nsec - start.tv_nsec);
+    } while (elapsed < 10000000);
+
+    const unsigned long long ticks = list_latency_ticks() - first;
+    return ticks ? (double)elapsed / (double)ticks : 1.0;
+}
+
+// values below LIST_LATENCY_SUB get a bucket each; above that, every power of two is split into
+// LIST_LATENCY_SUB linear steps
+static size_t list_latency_bucket(const unsigned long long ticks)
+{
+    if (ticks < LIST_LATENCY_SUB)
+        return (size_t)ticks;
+
+#if defined(__GNUC__) || defined(__clang__)
+    const int top = 63 - __builtin_clzll(ticks);
+#else
+    int top = 0;
+    while (ticks >> top > 1)
+        top++;
+#endif
+    const int magnitude = top - DYNAMIC_LIST_LATENCY_SUB_BITS;
+    return (size_t)magnitude * LIST_LATENCY_SUB + (size_t)(ticks >> magnitude);
+}
+
+// the highest value that lands in a bucket, so percentiles never understate the tail
+static unsigned long long list_latency_bucket_value(const size_t bucket)
+{
+    if (bucket < 2 * LIST_LATENCY_SUB)
+        return bucket;
+
+    const size_t magnitude = bucket / LIST_LATENCY_SUB - 1;
+    const unsigned long long low = (unsigned long long)(bucket % LIST_LATENCY_SUB + LIST_LATENCY_SUB) << magnitude;
+    return low + ((1ull << magnitude) - 1);
+}
+
+void list_latency_record(const int event, const unsigned long long ticks)
+{
+    ListLatencyHistogram* histogram = &list_latency_histograms[event];
+    histogram->counts[list_latency_bucket(ticks)]++;
+    if (histogram->total == 0 || ticks < histogram->min)
+        histogram->min = ticks;
+    if (ticks > histogram->max)
+        histogram->max = ticks;
+    histogram->total++;
+    histogram->sum += ticks;
+}
+
+void list_latency_snapshot(ListLatencyHistogram* histograms)
+{
+    memcpy(histograms, list_latency_histograms, sizeof(list_latency_histograms));
+}
+
+void list_latency_reset(void)
+{
+    memset(list_latency_histograms, 0, sizeof(list_latency_histograms));
+}
+
+void list_latency_merge(ListLatencyHistogram* into, const ListLatencyHistogram* from)
+{
+    if (from->total == 0)
+        return;
+
+    for (size_t bucket = 0; bucket < LIST_LATENCY_BUCKETS; bucket++)
+        into->counts[bucket] += from->counts[bucket];
+
+    if (into->total == 0 || from->min < into->min)
+        into->min = from->min;
+    if (from->max > into->max)
+        into->max = from->max;
+    into->total += from->total;
+    into->sum += from->sum;
+}
+
+unsigned long long list_latency_percentile(const ListLatencyHistogram* histogram, const double percentile)
+{
+    if (histogram->total == 0)
+        return 0;
+
+    unsigned long long target = (unsigned long long)((double)histogram->total * percentile / 100.0 + 0.5);
+    if (target == 0)
+        target = 1;
+
+    unsigned long long seen = 0;
+    for (size_t bucket = 0; bucket < LIST_LATENCY_BUCKETS; bucket++)
+    {
+        seen += histogram->counts[bucket];
+        if (seen >= target)
+        {
+            const unsigned long long value = list_latency_bucket_value(bucket);
+            return value < histogram->max ? value : histogram->max;
+        }
+    }
+    return histogram->max;
+}
+
+void list_latency_dump(FILE* out, const ListLatencyHistogram* histograms)
+{
+    const double ns = list_latency_tick_ns();
+
+    fprintf(out, "%-12s %12s %12s %12s %12s %12s %12s %12s\n", "event (ns)", "count", "mean", "p50", "p90",
+        "p99", "p99.9", "max");
+    for (int event = 0; event < LIST_LATENCY_EVENTS; event++)
+    {
+        const ListLatencyHistogram* histogram = &histograms[event];
+        if (histogram->total == 0)
+            continue;
+
+        fprintf(out, "%-12s %12llu %12.0f %12.0f %12.0f %12.0f %12.0f %12.0f\n", list_latency_names[event],
+            histogram->total, (double)histogram->sum / (double)histogram->total * ns,
+            (double)list_latency_percentile(histogram, 50) * ns,
+            (double)list_latency_percentile(histogram, 90) * ns,
+            (double)list_latency_percentile(histogram, 99) * ns,
+            (double)list_latency_percentile(histogram, 99.9) * ns,
+            (double)histogram->max * ns);
+    }
+}
+
+#else
+#define list_internal_latency_begin(name) ((void)0)
+#define list_internal_latency_end(event, name) ((void)0)
+#endif
+
+void* default_allocator_alloc(const size_t size, void* context)
+{
+    (void)context;
+    return malloc(size);
+}
+
+void* default_allocator_realloc(void* ptr, const size_t size, void* context)
+{
+    (void)context;
+    return realloc(ptr, size);
+}
+
+void default_allocator_free(void* ptr, void* context)
+{
+    (void)context;
+    free(ptr);
+}
+
+static Allocator default_allocator = {
+    .alloc = default_allocator_alloc,
+    .realloc = default_allocator_realloc,
+    .free = default_allocator_free,
+    .context = NULL,
+};
+
+#ifdef DYNAMIC_LIST_DIRTY_TRACKING
+// one bit per DYNAMIC_LIST_DIRTY_BLOCK bytes of item storage
+static size_t list_dirty_bitmap_size(const size_t capacity, const size_t stride)
+{
+    const size_t blocks = (capacity * stride + DYNAMIC_LIST_DIRTY_BLOCK - 1) / DYNAMIC_LIST_DIRTY_BLOCK;
+    return (blocks + 7) / 8;
+}
+#endif
+
+#ifdef DYNAMIC_LIST_SITES
+
+#include <stdatomic.h>
+
+#define LIST_SITE_BUCKETS 256
+#define LIST_SITE_HISTOGRAM 48
+
+struct ListSite
+{
+    const char* file;
+    int line;
+    const char* tag;
+    ListSite* next;
+#ifdef DYNAMIC_LIST_TRACK_SITES
+    ListPrelude* lists;
+#endif
+#ifdef DYNAMIC_LIST_ADAPTIVE_CAPACITY
+    // final lengths of freed lists, bucketed by bit width: bucket b counts lengths in [2^(b-1), 2^b)
+    atomic_uint lengths[LIST_SITE_HISTOGRAM];
+    atomic_uint samples;
+#endif
+};
+
+// sites live for the whole program; there's one per call site, so they are never freed
+static ListSite* list_site_buckets[LIST_SITE_BUCKETS];
+static ListSite list_unknown_site = {.file = "(unknown)"};
+static atomic_flag list_site_lock = ATOMIC_FLAG_INIT;
+
+static void list_site_acquire(void)
+{
+    while (atomic_flag_test_and_set_explicit(&list_site_lock, memory_order_acquire))
+        ;
+}
+
+static void list_site_release(void)
+{
+    atomic_flag_clear_explicit(&list_site_lock, memory_order_release);
+}
+
+static int list_same_string(const char* a, const char* b)
+{
+    return a == b || (a && b && strcmp(a, b) == 0);
+}
+
+// the lock must be held
+static ListSite* list_site_find(const char* file, const int line, const char* tag)
+{
+    if (!file)
+        return &list_unknown_site;
+
+    const size_t bucket = (size_t)line * 2654435761u % LIST_SITE_BUCKETS;
+    for (ListSite* site = list_site_buckets[bucket]; site; site = site->next)
+    {
+        if (site->line == line && list_same_string(site->file, file) && list_same_string(site->tag, tag))
+            return site;
+    }
+
+    ListSite* site = calloc(1, sizeof(ListSite));
+    if (!site)
+        return &list_unknown_site;
+
+    site->file = file;
+    site->line = line;
+    site->tag = tag;
+    site->next = list_site_buckets[bucket];
+    list_site_buckets[bucket] = site;
+    return site;
+}
+
+#ifdef DYNAMIC_LIST_ADAPTIVE_CAPACITY
+
+// picks the capacity that would have held 90% of the lists freed from this site
+static size_t list_site_capacity(ListSite* site, const size_t fallback)
+{
+    const unsigned samples = atomic_load_explicit(&site->samples, memory_order_relaxed);
+    if (site == &list_unknown_site || samples < DYNAMIC_LIST_ADAPTIVE_SAMPLES)
+        return fallback;
+
+    const unsigned threshold = samples - samples / 10;
+    unsigned seen = 0;
+    for (size_t bucket = 0; bucket < LIST_SITE_HISTOGRAM; bucket++)
+    {
+        seen += atomic_load_explicit(&site->lengths[bucket], memory_order_relaxed);
+        if (seen >= threshold)
+            return bucket == 0 ? 1 : (size_t)1 << bucket;
+    }
+
+    return fallback;
+}
+
+static void list_site_record(ListSite* site, size_t length)
+{
+    size_t bucket = 0;
+    for (; length; length >>= 1)
+        bucket++;
+    if (bucket >= LIST_SITE_HISTOGRAM)
+        bucket = LIST_SITE_HISTOGRAM - 1;
+
+    atomic_fetch_add_explicit(&site->lengths[bucket], 1, memory_order_relaxed);
+    if (atomic_fetch_add_explicit(&site->samples, 1, memory_order_relaxed) + 1 < DYNAMIC_LIST_ADAPTIVE_SAMPLES * 64)
+        return;
+
+    // halve the histogram now and then so a site follows changes in how its lists are used
+    list_site_acquire();
+    if (atomic_load_explicit(&site->samples, memory_order_relaxed) >= DYNAMIC_LIST_ADAPTIVE_SAMPLES * 64)
+    {
+        unsigned samples = 0;
+        for (size_t i = 0; i < LIST_SITE_HISTOGRAM; i++)
+        {
+            const unsigned halved = atomic_load_explicit(&site->lengths[i], memory_order_relaxed) / 2;
+            atomic_store_explicit(&site->lengths[i], halved, memory_order_relaxed);
+            samples += halved;
+        }
+        atomic_store_explicit(&site->samples, samples, memory_order_relaxed);
+    }
+    list_site_release();
+}
+
+#endif
+
+#ifdef DYNAMIC_LIST_TRACK_SITES
+
+// the lock must be held
+static void list_site_link(ListPrelude* prelude)
+{
+    ListSite* site = prelude->site;
+    prelude->site_prev = NULL;
+    prelude->site_next = site->lists;
+    if (site->lists)
+        site->lists->site_prev = prelude;
+    site->lists = prelude;
+}
+
+// the lock must be held
+static void list_site_unlink(ListPrelude* prelude)
+{
+    if (prelude->site_prev)
+        prelude->site_prev->site_next = prelude->site_next;
+    else
+        prelude->site->lists = prelude->site_next;
+
+    if (prelude->site_next)
+        prelude->site_next->site_prev = prelude->site_prev;
+}
+
+// the lock must be held
+static void list_site_collect(const ListSite* site, ListSiteStats* stats)
+{
+    memset(stats, 0, sizeof(ListSiteStats));
+    stats->file = site->file;
+    stats->line = site->line;
+    stats->tag = site->tag;
+
+    for (const ListPrelude* prelude = site->lists; prelude; prelude = prelude->site_next)
+    {
+        stats->lists++;
+        stats->length += prelude->length;
+        stats->capacity += prelude->capacity;
+        stats->bytes_used += list_bytes_used(prelude + 1);
+        stats->bytes_reserved += list_bytes_reserved(prelude + 1);
+    }
+}
+
+size_t list_site_stats(ListSiteStats* stats, const size_t max)
+{
+    size_t count = 0;
+    list_site_acquire();
+
+    if (list_unknown_site.lists)
+    {
+        if (count < max)
+            list_site_collect(&list_unknown_site, &stats[count]);
+        count++;
+    }
+
+    for (size_t bucket = 0; bucket < LIST_SITE_BUCKETS; bucket++)
+    {
+        for (const ListSite* site = list_site_buckets[bucket]; site; site = site->next)
+        {
+            if (!site->lists)
+                continue;
+            if (count < max)
+                list_site_collect(site, &stats[count]);
+            count++;
+        }
+    }
+
+    list_site_release();
+    return count;
+}
+
+static int list_site_compare_slack(const void* a, const void* b)
+{
+    const ListSiteStats* sa = a;
+    const ListSiteStats* sb = b;
+    const size_t slack_a = sa->bytes_reserved - sa->bytes_used;
+    const size_t slack_b = sb->bytes_reserved - sb->bytes_used;
+    return (slack_a < slack_b) - (slack_a > slack_b);
+}
+
+void list_site_report(FILE* out)
+{
+    // sites can be added between counting and collecting, so leave some room
+    const size_t max = list_site_stats(NULL, 0) + 16;
+    ListSiteStats* stats = malloc(max * sizeof(ListSiteStats));
+    if (!stats)
+        return;
+
+    size_t count = list_site_stats(stats, max);
+    if (count > max)
+        count = max;
+    qsort(stats, count, sizeof(ListSiteStats), list_site_compare_slack);
+
+    fprintf(out, "%-40s %8s %12s %12s %14s %14s\n", "site", "lists", "length", "capacity", "bytes", "slack bytes");
+    for (size_t i = 0; i < count; i++)
+    {
+        char site[512];
+        if (stats[i].tag)
+            snprintf(site, sizeof(site), "%s (%s:%d)", stats[i].tag, stats[i].file, stats[i].line);
+        else
+            snprintf(site, sizeof(site), "%s:%d", stats[i].file, stats[i].line);
+
+        fprintf(out, "%-40s %8zu %12zu %12zu %14zu %14zu\n", site, stats[i].lists, stats[i].length,
+            stats[i].capacity, stats[i].bytes_reserved, stats[i].bytes_reserved - stats[i].bytes_used);
+    }
+
+    free(stats);
+}
+
+#endif
+
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+#define list_internal_atomic_add(target, value) __atomic_add_fetch(target, value, __ATOMIC_RELAXED)
+#define list_internal_atomic_load(target) __atomic_load_n(target, __ATOMIC_RELAXED)
+#define list_internal_atomic_store(target, value) __atomic_store_n(target, value, __ATOMIC_RELAXED)
+#define list_internal_atomic_raise(target, expected, value) \
+    __atomic_compare_exchange_n(target, expected, value, 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED)
+// drops a reference, ordered so the last one to drop sees every write made under the others
+#define list_internal_atomic_release(target) __atomic_sub_fetch(target, 1, __ATOMIC_ACQ_REL)
+#else
+// without the builtins the counters are plain and only exact for single-threaded use
+#define list_internal_atomic_add(target, value) (*(target) += (value))
+#define list_internal_atomic_load(target) (*(target))
+#define list_internal_atomic_store(target, value) (*(target) = (value))
+#define list_internal_atomic_raise(target, expected, value) (*(target) = (value), 1)
+#define list_internal_atomic_release(target) (--*(target))
+#endif
+
+static void* list_batch_realloc(void* ptr, size_t size, void* context);
+
+// bytes are added and removed in one step, since size_t wraps the same way in both directions.
+// compiled out unless asked for, since every list shares the default allocator's counters
+static void list_account(Allocator* allocator, const size_t lists, const size_t added, const size_t removed)
+{
+#ifndef DYNAMIC_LIST_ACCOUNTING
+    (void)allocator;
+    (void)lists;
+    (void)added;
+    (void)removed;
+#else
+    // a batch's own allocator can't be seen from outside; its lists are accounted to the batch's
+    // parent, in create_lists_batch_at and list_batch_release
+    if (allocator->realloc == list_batch_realloc)
+        return;
+
+    if (lists)
+        list_internal_atomic_add(&allocator->live_lists, lists);
+
+    const size_t live = list_internal_atomic_add(&allocator->live_bytes, added - removed);
+    size_t peak = list_internal_atomic_load(&allocator->peak_bytes);
+    while (live > peak && !list_internal_atomic_raise(&allocator->peak_bytes, &peak, live))
+        ;
+#endif
+}
+
+size_t list_bytes_used(const void* list)
+{
+    const ListPrelude* prelude = list_prelude(list);
+    return sizeof(ListPrelude) + prelude->length * prelude->stride;
+}
+
+size_t list_bytes_reserved(const void* list)
+{
+    const ListPrelude* prelude = list_prelude(list);
+    return sizeof(ListPrelude) + prelude->capacity * prelude->stride;
+}
+
+ListAllocatorStats list_allocator_stats(const Allocator* allocator)
+{
+    if (allocator == NULL)
+        allocator = &default_allocator;
+
+    ListAllocatorStats stats;
+    stats.live_lists = list_internal_atomic_load(&allocator->live_lists);
+    stats.live_bytes = list_internal_atomic_load(&allocator->live_bytes);
+    stats.peak_bytes = list_internal_atomic_load(&allocator->peak_bytes);
+    return stats;
+}
+
+void list_allocator_reset_peak(Allocator* allocator)
+{
+    if (allocator == NULL)
+        allocator = &default_allocator;
+
+    list_internal_atomic_store(&allocator->peak_bytes, list_internal_atomic_load(&allocator->live_bytes));
+}
+
+// fills in a prelude for an empty list, with the site already set; accounting is left to the
+// caller, since a list in a batch is accounted to the batch's parent
+static void* list_init_prelude(ListPrelude* prelude, const size_t stride, const size_t capacity, Allocator* allocator)
+{
+    prelude->capacity = capacity;
+    prelude->length = 0;
+    prelude->allocator = allocator;
+    prelude->stride = stride;
+#ifdef DYNAMIC_LIST_DIRTY_TRACKING
+    prelude->dirty = NULL;
+#endif
+#ifdef DYNAMIC_LIST_TRACK_SITES
+    list_site_acquire();
+    list_site_link(prelude);
+    list_site_release();
+#endif
+
+    void* list = prelude + 1;
+    list_internal_annotate(list, capacity, 0);
+    list_internal_probe_create(list, capacity, stride, sizeof(ListPrelude) + stride * capacity);
+    return list;
+}
+
+void* create_list(const size_t stride, const size_t capacity, Allocator* allocator)
+{
+    return create_list_at(stride, capacity, allocator, NULL, 0, NULL);
+}
+
+void* create_list_at(const size_t stride, size_t capacity, Allocator* allocator, const char* file,
+    const int line, const char* tag)
+{
+#ifdef DYNAMIC_LIST_SITES
+    list_site_acquire();
+    ListSite* site = list_site_find(file, line, tag);
+    list_site_release();
+#else
+    (void)file;
+    (void)line;
+    (void)tag;
+#endif
+
+#ifdef DYNAMIC_LIST_ADAPTIVE_CAPACITY
+    capacity = list_site_capacity(site, capacity);
+#endif
+
+    if (allocator == NULL)
+        allocator = &default_allocator;
+
+    ListPrelude* prelude = allocator->alloc(sizeof(ListPrelude) + stride * capacity, allocator->context);
+    if (!prelude)
+        return NULL;
+
+#ifdef DYNAMIC_LIST_SITES
+    prelude->site = site;
+#endif
+    list_account(allocator, 1, sizeof(ListPrelude) + stride * capacity, 0);
+    return list_init_prelude(prelude, stride, capacity, allocator);
+}
+
+// a batch is one block from the parent allocator holding this header and then a slot per list.
+// its lists point at the allocator in the header, which hands every other pointer to the parent
+typedef struct
+{
+    Allocator allocator;
+    Allocator* parent;
+    unsigned char* slots;
+    size_t slot;
+    size_t count;
+    size_t refs;
+} ListBatch;
+
+static int list_batch_owns(const ListBatch* batch, const void* ptr)
+{
+    const unsigned char* address = ptr;
+    return address >= batch->slots && address < batch->slots + batch->slot * batch->count;
+}
+
+// the parent accounts for the lists of a batch, since that's where their memory comes from
+static void list_batch_release(ListBatch* batch, ListPrelude* prelude)
+{
+    list_account(batch->parent, (size_t)-1, 0, sizeof(ListPrelude) + prelude->capacity * prelude->stride);
+    if (list_internal_atomic_release(&batch->refs) == 0)
+        batch->parent->free(batch, batch->parent->context);
+}
+
+static void* list_batch_alloc(const size_t size, void* context)
+{
+    ListBatch* batch = context;
+    return batch->parent->alloc(size, batch->parent->context);
+}
+
+static void* list_batch_realloc(void* ptr, const size_t size, void* context)
+{
+    ListBatch* batch = context;
+    Allocator* parent = batch->parent;
+    if (!list_batch_owns(batch, ptr))
+        return parent->realloc(ptr, size, parent->context);
+
+    // a list growing out of its slot moves to its own block from the parent, and leaves the batch
+    ListPrelude* prelude = parent->alloc(size, parent->context);
+    if (!prelude)
+        return NULL;
+
+    const ListPrelude* old = ptr;
+    const size_t used = sizeof(ListPrelude) + old->capacity * old->stride;
+    memcpy(prelude, ptr, size < used ? size : used);
+    prelude->allocator = parent;
+    list_batch_release(batch, ptr);
+    return prelude;
+}
+
+static void list_batch_free(void* ptr, void* context)
+{
+    ListBatch* batch = context;
+    if (list_batch_owns(batch, ptr))
+        list_batch_release(batch, ptr);
+    else
+        batch->parent->free(ptr, batch->parent->context);
+}
+
+int create_lists_batch(const size_t count, const size_t stride, const size_t capacity, Allocator* allocator,
+    void* lists)
+{
+    return create_lists_batch_at(count, stride, capacity, allocator, lists, NULL, 0, NULL);
+}
+
+int create_lists_batch_at(const size_t count, const size_t stride, size_t capacity, Allocator* allocator,
+    void* lists, const char* file, const int line, const char* tag)
+{
+#ifdef DYNAMIC_LIST_SITES
+    list_site_acquire();
+    ListSite* site = list_site_find(file, line, tag);
+    list_site_release();
+#else
+    (void)file;
+    (void)line;
+    (void)tag;
+#endif
+
+    if (count == 0)
+        return 0;
+    if (allocator == NULL)
+        allocator = &default_allocator;
+    // growth doubles the capacity, so it can't start at 0
+    if (capacity == 0)
+        capacity = 1;
+
+    // preludes are aligned like max_align_t, so rounding the items up keeps every slot aligned
+    const size_t align = _Alignof(max_align_t);
+    const size_t header = (sizeof(ListBatch) + align - 1) / align * align;
+    if (stride > 0 && capacity > (SIZE_MAX - sizeof(ListPrelude) - align) / stride)
+        return -1;
+    const size_t slot = sizeof(ListPrelude) + (stride * capacity + align - 1) / align * align;
+    if (count > (SIZE_MAX - header) / slot)
+        return -1;
+
+    ListBatch* batch = allocator->alloc(header + slot * count, allocator->context);
+    if (!batch)
+        return -1;
+
+    batch->allocator = (Allocator){
+        .alloc = list_batch_alloc,
+        .realloc = list_batch_realloc,
+        .free = list_batch_free,
+        .context = batch,
+    };
+    batch->parent = allocator;
+    batch->slots = (unsigned char*)batch + header;
+    batch->slot = slot;
+    batch->count = count;
+    batch->refs = count;
+
+    for (size_t i = 0; i < count; i++)
+    {
+        ListPrelude* prelude = (ListPrelude*)(batch->slots + slot * i);
+#ifdef DYNAMIC_LIST_SITES
+        prelude->site = site;
+#endif
+        list_account(allocator, 1, sizeof(ListPrelude) + stride * capacity, 0);
+        void* list = list_init_prelude(prelude, stride, capacity, &batch->allocator);
+        memcpy((unsigned char*)lists + i * sizeof(void*), &list, sizeof(void*));
+    }
+
+    return 0;
+}
+
+#if !defined(_WIN32)
+static void* list_mapped_realloc(void* ptr, size_t size, void* context);
+#endif
+
+// list_ensure_capacity_relocate frees the old block itself instead of calling realloc, so it has
+// to do the handover that the realloc of a batch or a mapped file does
+static Allocator* list_relocated_owner(Allocator* allocator)
+{
+    if (allocator->realloc == list_batch_realloc)
+        return ((ListBatch*)allocator->context)->parent;
+#if !defined(_WIN32)
+    if (allocator->realloc == list_mapped_realloc)
+        return &default_allocator;
+#endif
+    return allocator;
+}
+
+int list_pool_init_size(ListPool* pool, size_t size, Allocator* allocator)
+{
+    // a slot has to hold the vacant list's pointer, and sizes are multiples of the alignment
+    // already, so rounding to a pointer keeps every slot aligned
+    if (size < sizeof(void*))
+        size = sizeof(void*);
+    size = (size + sizeof(void*) - 1) / sizeof(void*) * sizeof(void*);
+
+    pool->allocator = allocator;
+    pool->size = size;
+    pool->chunks = create_list(sizeof(unsigned char*), DEFAULT_LIST_CAPACITY, allocator);
+    pool->current = 0;
+    pool->vacant = NULL;
+    pool->live = 0;
+    return pool->chunks ? 0 : -1;
+}
+
+void* list_pool_alloc(ListPool* pool)
+{
+    unsigned char* object = pool->vacant;
+    if (object)
+    {
+        list_internal_unpoison(object, pool->size);
+        memcpy(&pool->vacant, object, sizeof(void*));
+        pool->live++;
+        return object;
+    }
+
+    // chunks after the current one are only there when list_pool_clear emptied them
+    unsigned char* chunk = NULL;
+    while (pool->current < list_len(pool->chunks))
+    {
+        chunk = pool->chunks[pool->current];
+        if (list_len(chunk) < list_cap(chunk))
+            break;
+        chunk = NULL;
+        pool->current++;
+    }
+
+    if (!chunk)
+    {
+        size_t capacity = DEFAULT_LIST_CAPACITY;
+        if (list_len(pool->chunks) > 0)
+        {
+            capacity = list_cap(pool->chunks[list_len(pool->chunks) - 1]) * 2;
+            if (capacity > DYNAMIC_LIST_POOL_CHUNK)
+                capacity = DYNAMIC_LIST_POOL_CHUNK;
+        }
+
+        chunk = create_list(pool->size, capacity, pool->allocator);
+        if (!chunk)
+            return NULL;
+        list_append(pool->chunks, chunk);
+        pool->current = list_len(pool->chunks) - 1;
+    }
+
+    object = chunk + list_len(chunk) * pool->size;
+    list_internal_annotate(chunk, list_len(chunk), list_len(chunk) + 1);
+    list_len(chunk) += 1;
+    pool->live++;
+    return object;
+}
+
+void list_pool_free(ListPool* pool, void* object)
+{
+    memcpy(object, &pool->vacant, sizeof(void*));
+    list_internal_poison(object, pool->size);
+    pool->vacant = object;
+    pool->live--;
+}
+
+void list_pool_clear(ListPool* pool)
+{
+    // vacant slots are poisoned, which the container annotation list_clear moves would trip over
+    for (size_t i = 0; i < list_len(pool->chunks); i++)
+    {
+        list_internal_unpoison(pool->chunks[i], list_len(pool->chunks[i]) * pool->size);
+        list_clear(pool->chunks[i]);
+    }
+
+    pool->current = 0;
+    pool->vacant = NULL;
+    pool->live = 0;
+}
+
+void list_pool_destroy(ListPool* pool)
+{
+    for (size_t i = 0; i < list_len(pool->chunks); i++)
+        list_free(pool->chunks[i]);
+    list_free(pool->chunks);
+
+    pool->chunks = NULL;
+    pool->vacant = NULL;
+    pool->live = 0;
+}
+
+void destroy_list(void* list)
+{
+    ListPrelude* prelude = list_prelude(list);
+    Allocator* allocator = prelude->allocator;
+
+    list_internal_probe_free(list, prelude->capacity, prelude->stride,
+        sizeof(ListPrelude) + prelude->capacity * prelude->stride);
+    list_account(allocator, (size_t)-1, 0, list_bytes_reserved(list));
+
+#ifdef DYNAMIC_LIST_ADAPTIVE_CAPACITY
+    if (prelude->site)
+        list_site_record(prelude->site, prelude->length);
+#endif
+#ifdef DYNAMIC_LIST_TRACK_SITES
+    if (prelude->site)
+    {
+        list_site_acquire();
+        list_site_unlink(prelude);
+        list_site_release();
+    }
+#endif
+
+#ifdef DYNAMIC_LIST_DIRTY_TRACKING
+    if (prelude->dirty)
+        allocator->free(prelude->dirty, allocator->context);
+#endif
+
+    // unpoisoned in full, in case the allocator reuses the memory or the length was set by hand
+    list_internal_annotate(list, 0, prelude->capacity);
+    allocator->free(prelude, allocator->context);
+}
+
+void* list_ensure_capacity(void *list, const size_t item_count, const size_t item_size) {
+    return list_ensure_capacity_relocate(list, item_count, item_size, NULL);
+}
+
+void* list_ensure_capacity_relocate(void *list, const size_t item_count, const size_t item_size,
+    const ListRelocateFn relocate) {
+    ListPrelude* prelude = list_prelude(list);
+    const size_t desired_capacity = prelude->length + item_count;
+
+    if (prelude->capacity < desired_capacity) {
+        // a mapped .npy list holding an empty array starts with no capacity at all
+        size_t new_capacity = prelude->capacity ? prelude->capacity * 2 : 1;
+        while (new_capacity < desired_capacity) {
+            new_capacity *= 2;
+        }
+
+        const size_t new_size = sizeof(ListPrelude) + new_capacity * item_size;
+        list_internal_latency_begin(latency_start);
+
+#ifdef DYNAMIC_LIST_DIRTY_TRACKING
+        // grown first, so failing to grow it leaves nothing to undo. whichever allocator the list
+        // moves to frees blocks from the one it's moving away from
+        if (prelude->dirty)
+        {
+            const size_t old_bytes = list_dirty_bitmap_size(prelude->capacity, prelude->stride);
+            const size_t new_bytes = list_dirty_bitmap_size(new_capacity, prelude->stride);
+            unsigned char* dirty = prelude->allocator->realloc(prelude->dirty, new_bytes, prelude->allocator->context);
+            if (!dirty)
+                return NULL;
+            memset(dirty + old_bytes, 0, new_bytes - old_bytes);
+            prelude->dirty = dirty;
+        }
+#endif
+
+#ifdef DYNAMIC_LIST_TRACK_SITES
+        // unlinked while the prelude moves, so a concurrent report never follows a stale pointer
+        ListSite* site = prelude->site;
+        if (site)
+        {
+            list_site_acquire();
+            list_site_unlink(prelude);
+            list_site_release();
+        }
+#endif
+
+        // accounted as a free and a new list, since the allocator can hand the list over to another
+        // one (and release itself) while moving it
+        list_account(prelude->allocator, (size_t)-1, 0, list_bytes_reserved(list));
+        list_internal_annotate(list, 0, prelude->capacity);
+        ListPrelude* moved;
+        if (relocate)
+        {
+            // items that can't be moved with memcpy are moved into a new block by the caller
+            Allocator* allocator = prelude->allocator;
+            moved = allocator->alloc(new_size, allocator->context);
+            if (moved)
+            {
+                memcpy(moved, prelude, sizeof(ListPrelude));
+                moved->allocator = list_relocated_owner(allocator);
+                relocate(moved + 1, prelude + 1, prelude->length);
+                allocator->free(prelude, allocator->context);
+            }
+        }
+        else
+        {
+            moved = prelude->allocator->realloc(prelude, new_size, prelude->allocator->context);
+        }
+
+        if (!moved)
+        {
+            // the list is left as it was, so put back what was undone for the move
+            list_account(prelude->allocator, 1, list_bytes_reserved(list), 0);
+            list_internal_annotate(list, prelude->capacity, prelude->length);
+#ifdef DYNAMIC_LIST_TRACK_SITES
+            if (site)
+            {
+                list_site_acquire();
+                list_site_link(prelude);
+                list_site_release();
+            }
+#endif
+            return NULL;
+        }
+
+        prelude = moved;
+        list_internal_probe_grow(list, prelude + 1, prelude->capacity, new_capacity, item_size, new_size);
+
+#ifdef DYNAMIC_LIST_TRACK_SITES
+        if (site)
+        {
+            list_site_acquire();
+            list_site_link(prelude);
+            list_site_release();
+        }
+#endif
+        prelude->capacity = new_capacity;
+        list_internal_annotate(prelude + 1, new_capacity, prelude->length);
+        list_account(prelude->allocator, 1, new_size, 0);
+        list_internal_latency_end(LIST_LATENCY_GROW, latency_start);
+    }
+
+    return prelude + 1;
+}
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+static int list_host_is_little_endian(void)
+{
+    const unsigned int one = 1;
+    return *(const unsigned char*)&one == 1;
+}
+
+// checks a numpy dtype string like "<i4" against the stride and the host byte order, and returns
+// its byte order character with 1 byte types normalized to '|'
+static char list_npy_byte_order(const char* descr, const size_t stride)
+{
+    if (strlen(descr) < 3 || strchr("biufc", descr[1]) == NULL)
+        return 0;
+
+    char* end = NULL;
+    const unsigned long width = strtoul(descr + 2, &end, 10);
+    if (*end != '\0' || width != stride)
+        return 0;
+
+    if (stride == 1)
+        return descr[0] == '<' || descr[0] == '>' || descr[0] == '|' || descr[0] == '=' ? '|' : 0;
+
+    const char native = list_host_is_little_endian() ? '<' : '>';
+    if (descr[0] == '=' || descr[0] == native)
+        return native;
+    return 0;
+}
+
+static int list_npy_same_dtype(const char* a, const char* b, const size_t stride)
+{
+    return list_npy_byte_order(a, stride) != 0 && list_npy_byte_order(a, stride) == list_npy_byte_order(b, stride)
+        && strcmp(a + 1, b + 1) == 0;
+}
+
+int list_save_npy(const void* list, const char* path, const char* descr)
+{
+    const ListPrelude* prelude = list_prelude(list);
+    if (!list_npy_byte_order(descr, prelude->stride))
+        return -1;
+
+    // version 1.0 header, padded with spaces so the data starts on a 64 byte boundary
+    char header[256];
+    int text = snprintf(header + 10, sizeof(header) - 10, "{'descr': '%s', 'fortran_order': False, 'shape': (%zu,), }",
+        descr, prelude->length);
+    if (text < 0 || (size_t)text + 11 > sizeof(header))
+        return -1;
+
+    size_t total = 10 + (size_t)text + 1;
+    while (total % 64 != 0)
+        header[total++ - 1] = ' ';
+    header[total - 1] = '\n';
+
+    memcpy(header, "\x93NUMPY\x01\x00", 8);
+    header[8] = (char)((total - 10) & 0xFF);
+    header[9] = (char)((total - 10) >> 8);
+
+    FILE* file = fopen(path, "wb");
+    if (!file)
+        return -1;
+
+    int result = fwrite(header, 1, total, file) == total ? 0 : -1;
+    if (result == 0 && fwrite(list, prelude->stride, prelude->length, file) != prelude->length)
+        result = -1;
+    if (fclose(file) != 0)
+        result = -1;
+    return result;
+}
+
+#define LIST_NPY_MAX_HEADER 4096
+
+// parses the header at the start of a .npy file, returning the offset of the data or 0. `size` is
+// how many bytes are available at `bytes`, `file_size` is used to reject truncated files.
+static size_t list_npy_parse(const unsigned char* bytes, const size_t size, const size_t file_size,
+    const char* descr, const size_t stride, size_t* length)
+{
+    if (size < 10 || memcmp(bytes, "\x93NUMPY", 6) != 0)
+        return 0;
+
+    size_t header_size;
+    size_t offset;
+    if (bytes[6] == 1)
+    {
+        header_size = bytes[8] | (size_t)bytes[9] << 8;
+        offset = 10;
+    }
+    else if ((bytes[6] == 2 || bytes[6] == 3) && size >= 12)
+    {
+        header_size = bytes[8] | (size_t)bytes[9] << 8 | (size_t)bytes[10] << 16 | (size_t)bytes[11] << 24;
+        offset = 12;
+    }
+    else
+    {
+        return 0;
+    }
+
+    if (header_size > size - offset || header_size >= LIST_NPY_MAX_HEADER)
+        return 0;
+
+    char text[LIST_NPY_MAX_HEADER];
+    memcpy(text, bytes + offset, header_size);
+    text[header_size] = '\0';
+    offset += header_size;
+
+    char file_descr[32];
+    const char* field = strstr(text, "'descr':");
+    if (!field || sscanf(field + 8, " '%31[^']'", file_descr) != 1)
+        return 0;
+    if (descr ? !list_npy_same_dtype(file_descr, descr, stride) : !list_npy_byte_order(file_descr, stride))
+        return 0;
+
+    field = strstr(text, "'shape':");
+    const char* open = field ? strchr(field, '(') : NULL;
+    const char* close = open ? strchr(open, ')') : NULL;
+    if (!close)
+        return 0;
+
+    size_t count = 1;
+    size_t dimensions = 0;
+    for (const char* cursor = open + 1; cursor < close;)
+    {
+        char* end = NULL;
+        const unsigned long long dimension = strtoull(cursor, &end, 10);
+        if (end == cursor)
+        {
+            cursor++;
+            continue;
+        }
+        // a shape whose product wraps could otherwise pass the size check below
+        if (dimension > SIZE_MAX || (dimension != 0 && count > SIZE_MAX / dimension))
+            return 0;
+        count *= (size_t)dimension;
+        dimensions++;
+        cursor = end;
+    }
+
+    // fortran ordered items only line up with a flat list when there's a single dimension
+    field = strstr(text, "'fortran_order':");
+    if (!field || (dimensions > 1 && strncmp(field + 16, " True", 5) == 0))
+        return 0;
+    if (count > (file_size - offset) / stride)
+        return 0;
+
+    *length = count;
+    return offset;
+}
+
+void* create_list_from_npy(const char* path, const char* descr, const size_t stride, Allocator* allocator)
+{
+    FILE* file = fopen(path, "rb");
+    if (!file)
+        return NULL;
+
+    // the shape is checked against the file's size, so a bogus one fails before anything is allocated
+    long file_size = -1;
+    if (fseek(file, 0, SEEK_END) == 0)
+        file_size = ftell(file);
+    if (file_size <= 0 || fseek(file, 0, SEEK_SET) != 0)
+    {
+        fclose(file);
+        return NULL;
+    }
+
+    unsigned char* header = create_list(1, LIST_NPY_MAX_HEADER + 12, allocator);
+    unsigned char* list = NULL;
+    size_t length = 0;
+    if (header)
+        list_internal_annotate(header, 0, LIST_NPY_MAX_HEADER + 12);
+    const size_t read = header ? fread(header, 1, LIST_NPY_MAX_HEADER + 12, file) : 0;
+    const size_t offset = read ? list_npy_parse(header, read, (size_t)file_size, descr, stride, &length) : 0;
+    if (offset && fseek(file, (long)offset, SEEK_SET) == 0)
+    {
+        list = create_list(stride, length ? length : 1, allocator);
+        if (list)
+            list_internal_annotate(list, 0, length);
+        if (list && fread(list, stride, length, file) == length)
+        {
+            list_len(list) = length;
+        }
+        else if (list)
+        {
+            list_free(list);
+            list = NULL;
+        }
+    }
+
+    if (header)
+        list_free(header);
+    fclose(file);
+    return list;
+}
+
+#if !defined(_WIN32)
+
+typedef struct
+{
+    Allocator allocator;
+    void* base;
+    size_t size;
+    ListPrelude* prelude;
+} ListMappedFile;
+
+static void* list_mapped_alloc(const size_t size, void* context)
+{
+    (void)context;
+    return malloc(size);
+}
+
+static void list_mapped_unmap(ListMappedFile* mapped)
+{
+    munmap(mapped->base, mapped->size);
+    free(mapped);
+}
+
+// growing a mapped list moves it onto the heap, after which it's an ordinary list
+static void* list_mapped_realloc(void* ptr, const size_t size, void* context)
+{
+    ListMappedFile* mapped = context;
+    if (ptr != mapped->prelude)
+        return realloc(ptr, size);
+
+    ListPrelude* prelude = malloc(size);
+    if (!prelude)
+        return NULL;
+
+    const size_t available = mapped->size - (size_t)((unsigned char*)mapped->prelude - (unsigned char*)mapped->base);
+    memcpy(prelude, mapped->prelude, size < available ? size : available);
+    prelude->allocator = &default_allocator;
+    list_mapped_unmap(mapped);
+    return prelude;
+}
+
+static void list_mapped_free(void* ptr, void* context)
+{
+    ListMappedFile* mapped = context;
+    if (ptr == mapped->prelude)
+        list_mapped_unmap(mapped);
+    else
+        free(ptr);
+}
+
+void* create_list_map_npy(const char* path, const char* descr, const size_t stride)
+{
+    const int fd = open(path, O_RDONLY);
+    if (fd < 0)
+        return NULL;
+
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size <= 0)
+    {
+        close(fd);
+        return NULL;
+    }
+
+    // a private mapping never writes back to the file, so the prelude can be written over the
+    // tail of the header; only the page holding it gets copied
+    const size_t size = (size_t)info.st_size;
+    unsigned char* base = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (base == MAP_FAILED)
+        return NULL;
+
+    size_t length = 0;
+    const size_t offset = list_npy_parse(base, size, size, descr, stride, &length);
+    ListMappedFile* mapped = NULL;
+    if (offset >= sizeof(ListPrelude) && (offset - sizeof(ListPrelude)) % _Alignof(ListPrelude) == 0)
+        mapped = malloc(sizeof(ListMappedFile));
+
+    if (!mapped)
+    {
+        munmap(base, size);
+        return offset ? create_list_from_npy(path, descr, stride, NULL) : NULL;
+    }
+
+    mapped->allocator = (Allocator){
+        .alloc = list_mapped_alloc,
+        .realloc = list_mapped_realloc,
+        .free = list_mapped_free,
+        .context = mapped,
+    };
+    mapped->base = base;
+    mapped->size = size;
+    mapped->prelude = (ListPrelude*)(base + offset) - 1;
+
+    ListPrelude* prelude = mapped->prelude;
+    memset(prelude, 0, sizeof(ListPrelude));
+    prelude->capacity = length;
+    prelude->length = length;
+    prelude->allocator = &mapped->allocator;
+    prelude->stride = stride;
+    list_account(prelude->allocator, 1, list_bytes_reserved(prelude + 1), 0);
+    return prelude + 1;
+}
+
+#else
+
+void* create_list_map_npy(const char* path, const char* descr, const size_t stride)
+{
+    return create_list_from_npy(path, descr, stride, NULL);
+}
+
+#endif
+
+// primitive Arrow formats a list can be exported as, with the item width each one requires
+static const struct
+{
+    const char* format;
+    size_t width;
+} list_arrow_formats[] = {
+    {"c", 1}, {"C", 1},
+    {"s", 2}, {"S", 2}, {"e", 2},
+    {"i", 4}, {"I", 4}, {"f", 4},
+    {"l", 8}, {"L", 8}, {"g", 8},
+};
+
+static const char* list_arrow_format(const char* format, const size_t stride)
+{
+    for (size_t i = 0; i < sizeof(list_arrow_formats) / sizeof(list_arrow_formats[0]); i++)
+    {
+        if (strcmp(format, list_arrow_formats[i].format) == 0)
+            return list_arrow_formats[i].width == stride ? list_arrow_formats[i].format : NULL;
+    }
+    return NULL;
+}
+
+typedef struct
+{
+    const void* buffers[2];
+    void* list;
+} ListArrowPrivate;
+
+static void list_arrow_release_schema(struct ArrowSchema* schema)
+{
+    // every string in an exported schema is static
+    schema->release = NULL;
+}
+
+static void list_arrow_release_array(struct ArrowArray* array)
+{
+    ListArrowPrivate* private_data = array->private_data;
+    void* list = private_data->list;
+    Allocator* allocator = list_prelude(list)->allocator;
+
+    // freed before the list, since a batch or mapped file keeps its allocator in the block that
+    // freeing its last list releases
+    allocator->free(private_data, allocator->context);
+    destroy_list(list);
+    array->release = NULL;
+}
+
+int list_to_arrow_array(void* list, const char* format, struct ArrowArray* array, struct ArrowSchema* schema)
+{
+    ListPrelude* prelude = list_prelude(list);
+    const char* exported = list_arrow_format(format, prelude->stride);
+    if (!exported)
+        return -1;
+
+    ListArrowPrivate* private_data = prelude->allocator->alloc(sizeof(ListArrowPrivate), prelude->allocator->context);
+    if (!private_data)
+        return -1;
+
+    private_data->buffers[0] = NULL;
+    private_data->buffers[1] = list;
+    private_data->list = list;
+
+    array->length = (int64_t)prelude->length;
+    array->null_count = 0;
+    array->offset = 0;
+    array->n_buffers = 2;
+    array->n_children = 0;
+    array->buffers = private_data->buffers;
+    array->children = NULL;
+    array->dictionary = NULL;
+    array->release = list_arrow_release_array;
+    array->private_data = private_data;
+
+    schema->format = exported;
+    schema->name = "";
+    schema->metadata = NULL;
+    schema->flags = 0;
+    schema->n_children = 0;
+    schema->children = NULL;
+    schema->dictionary = NULL;
+    schema->release = list_arrow_release_schema;
+    schema->private_data = NULL;
+    return 0;
+}
+
+void* list_from_arrow_array(struct ArrowArray* array, const struct ArrowSchema* schema, Allocator* allocator)
+{
+    if (!array->release || array->n_buffers != 2 || array->n_children != 0 || array->length < 0 || array->offset < 0)
+        return NULL;
+    if (array->null_count > 0 || (array->null_count < 0 && array->buffers[0] != NULL))
+        return NULL;
+
+    size_t stride = 0;
+    for (size_t i = 0; i < sizeof(list_arrow_formats) / sizeof(list_arrow_formats[0]); i++)
+    {
+        if (strcmp(schema->format, list_arrow_formats[i].format) == 0)
+            stride = list_arrow_formats[i].width;
+    }
+    if (stride == 0)
+        return NULL;
+
+    // an array exported from a list is handed back as that same list
+    if (array->release == list_arrow_release_array && array->offset == 0)
+    {
+        ListArrowPrivate* private_data = array->private_data;
+        void* list = private_data->list;
+        Allocator* owner = list_prelude(list)->allocator;
+
+        if (list_prelude(list)->stride == stride && list_prelude(list)->length == (size_t)array->length)
+        {
+            owner->free(private_data, owner->context);
+            array->release = NULL;
+            return list;
+        }
+    }
+
+    const size_t length = (size_t)array->length;
+    unsigned char* list = create_list(stride, length ? length : 1, allocator);
+    if (!list)
+        return NULL;
+
+    list_internal_annotate(list, 0, length);
+    if (length > 0)
+        memcpy(list, (const unsigned char*)array->buffers[1] + (size_t)array->offset * stride, length * stride);
+    list_len(list) = length;
+
+    array->release(array);
+    return list;
+}
+
+#if defined(__AVX2__) || defined(__SSSE3__) || defined(__SSE2__) || defined(_M_X64)
+#include <immintrin.h>
+#endif
+
+#define LIST_HASH_PRIME_1 0x9E3779B185EBCA87ull
+#define LIST_HASH_PRIME_2 0xC2B2AE3D27D4EB4Full
+#define LIST_HASH_PRIME_32 0x9E3779B1u
+
+// stripe s of a block mixes with secret words [s, s + 8), and the last 8 words scramble each block
+static const unsigned long long list_hash_secret[24] = {
+    0x2CB0F69F4ABEA221ull, 0x9417034723148989ull, 0xDD555950609DFE03ull, 0xDBAFB150DEB12800ull,
+    0x7E789B2E6C442CB6ull, 0xF41E5636C7E4F8C4ull, 0x0959D150F8FBA7E4ull, 0xA97316F13CDB9EEAull,
+    0x74CD8258F9520068ull, 0x55C74A62E116868Bull, 0xD2F4C799A2023CBDull, 0xDF98CB79A37B51B9ull,
+    0x396F5885524F3905ull, 0xAF1D56386CA3B276ull, 0xA9FFBE6B5104E85Aull, 0x6BD0C51B9FD533B3ull,
+    0x980CE91C50AB4B56ull, 0x28AC395780FE62C5ull, 0x768912E3A6BCEDC7ull, 0x50B3E8C9332C7C88ull,
+    0xCE3BBFE520BD47DAull, 0xCBA6C8E8E0BB7C4Full, 0xBF194DB8434A346Dull, 0x7D8F2A7B60416D7Full,
+};
+
+static unsigned long long list_bswap64(unsigned long long value)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_bswap64(value);
+#else
+    value = (value & 0x00000000FFFFFFFFull) << 32 | (value & 0xFFFFFFFF00000000ull) >> 32;
+    value = (value & 0x0000FFFF0000FFFFull) << 16 | (value & 0xFFFF0000FFFF0000ull) >> 16;
+    return (value & 0x00FF00FF00FF00FFull) << 8 | (value & 0xFF00FF00FF00FF00ull) >> 8;
+#endif
+}
+
+// words are read little endian so a hash only depends on the bytes, not on the host
+static unsigned long long list_hash_read64(const unsigned char* p)
+{
+    unsigned long long value;
+    memcpy(&value, p, sizeof(value));
+    return list_host_is_little_endian() ? value : list_bswap64(value);
+}
+
+static unsigned long long list_hash_fold(const unsigned long long a, const unsigned long long b)
+{
+#ifdef __SIZEOF_INT128__
+    // __extension__ keeps -Wpedantic quiet about the non-standard type
+    __extension__ typedef unsigned __int128 list_uint128;
+    const list_uint128 product = (list_uint128)a * b;
+    return (unsigned long long)product ^ (unsigned long long)(product >> 64);
+#else
+    const unsigned long long lo_lo = (a & 0xFFFFFFFF) * (b & 0xFFFFFFFF);
+    const unsigned long long hi_lo = (a >> 32) * (b & 0xFFFFFFFF);
+    const unsigned long long lo_hi = (a & 0xFFFFFFFF) * (b >> 32);
+    const unsigned long long hi_hi = (a >> 32) * (b >> 32);
+    const unsigned long long cross = (lo_lo >> 32) + (hi_lo & 0xFFFFFFFF) + lo_hi;
+    const unsigned long long high = (hi_lo >> 32) + (cross >> 32) + hi_hi;
+    const unsigned long long low = (cross << 32) | (lo_lo & 0xFFFFFFFF);
+    return low ^ high;
+#endif
+}
+
+// one 64 byte stripe: every lane adds its neighbour's input plus the 32x32 product of its own
+// keyed input. the SIMD paths compute exactly the same values as the scalar one.
+static void list_hash_accumulate(unsigned long long* acc, const unsigned char* data, const unsigned long long* secret)
+{
+#if defined(__AVX2__)
+    for (size_t i = 0; i < 2; i++)
+    {
+        __m256i* lanes = (__m256i*)acc + i;
+        const __m256i input = _mm256_loadu_si256((const __m256i*)data + i);
+        const __m256i keyed = _mm256_xor_si256(input, _mm256_loadu_si256((const __m256i*)secret + i));
+        const __m256i product = _mm256_mul_epu32(keyed, _mm256_shuffle_epi32(keyed, _MM_SHUFFLE(0, 3, 0, 1)));
+        const __m256i swapped = _mm256_shuffle_epi32(input, _MM_SHUFFLE(1, 0, 3, 2));
+        _mm256_storeu_si256(lanes, _mm256_add_epi64(_mm256_loadu_si256(lanes), _mm256_add_epi64(product, swapped)));
+    }
+#elif defined(__SSE2__) || defined(_M_X64)
+    for (size_t i = 0; i < 4; i++)
+    {
+        __m128i* lanes = (__m128i*)acc + i;
+        const __m128i input = _mm_loadu_si128((const __m128i*)data + i);
+        const __m128i keyed = _mm_xor_si128(input, _mm_loadu_si128((const __m128i*)secret + i));
+        const __m128i product = _mm_mul_epu32(keyed, _mm_shuffle_epi32(keyed, _MM_SHUFFLE(0, 3, 0, 1)));
+        const __m128i swapped = _mm_shuffle_epi32(input, _MM_SHUFFLE(1, 0, 3, 2));
+        _mm_storeu_si128(lanes, _mm_add_epi64(_mm_loadu_si128(lanes), _mm_add_epi64(product, swapped)));
+    }
+#else
+    for (size_t i = 0; i < 8; i++)
+    {
+        const unsigned long long input = list_hash_read64(data + i * 8);
+        const unsigned long long keyed = input ^ secret[i];
+        acc[i ^ 1] += input;
+        acc[i] += (keyed & 0xFFFFFFFF) * (keyed >> 32);
+    }
+#endif
+}
+
+static void list_hash_scramble(unsigned long long* acc)
+{
+    for (size_t i = 0; i < 8; i++)
+    {
+        unsigned long long lane = acc[i];
+        lane ^= lane >> 47;
+        lane ^= list_hash_secret[16 + i];
+        acc[i] = lane * LIST_HASH_PRIME_32;
+    }
+}
+
+static void list_hash_stripe(ListHashState* state, const unsigned char* data)
+{
+    list_hash_accumulate(state->accumulators, data, list_hash_secret + state->stripe);
+    if (++state->stripe == 16)
+    {
+        list_hash_scramble(state->accumulators);
+        state->stripe = 0;
+    }
+}
+
+void list_hash_init(ListHashState* state, const unsigned long long seed)
+{
+    for (size_t i = 0; i < 8; i++)
+        state->accumulators[i] = list_hash_secret[16 + i] ^ seed;
+    state->buffered = 0;
+    state->stripe = 0;
+    state->total = 0;
+    state->seed = seed;
+    state->consumed = 0;
+}
+
+void list_hash_update(ListHashState* state, const void* data, size_t size)
+{
+    const unsigned char* bytes = data;
+    state->total += size;
+
+    if (state->buffered > 0)
+    {
+        const size_t fill = 64 - state->buffered < size ? 64 - state->buffered : size;
+        memcpy(state->buffer + state->buffered, bytes, fill);
+        state->buffered += fill;
+        bytes += fill;
+        size -= fill;
+
+        if (state->buffered < 64)
+            return;
+        list_hash_stripe(state, state->buffer);
+        state->buffered = 0;
+    }
+
+    for (; size >= 64; bytes += 64, size -= 64)
+        list_hash_stripe(state, bytes);
+
+    memcpy(state->buffer, bytes, size);
+    state->buffered = size;
+}
+
+int list_hash_sync(ListHashState* state, const void* list)
+{
+    const ListPrelude* prelude = list_prelude(list);
+    if (prelude->length < state->consumed)
+        return -1;
+
+    const unsigned char* items = list;
+    list_hash_update(state, items + state->consumed * prelude->stride, (prelude->length - state->consumed) * prelude->stride);
+    state->consumed = prelude->length;
+    return 0;
+}
+
+static unsigned long long list_hash_finish(const ListHashState* state, const size_t secret_offset, unsigned long long hash)
+{
+    const unsigned long long* secret = list_hash_secret;
+    for (size_t i = 0; i < 8; i += 2)
+        hash += list_hash_fold(state->accumulators[i] ^ secret[secret_offset + i], state->accumulators[i + 1] ^ secret[secret_offset + i + 1]);
+
+    // the unprocessed tail is always shorter than a stripe
+    const unsigned char* tail = state->buffer;
+    size_t word = 0;
+    for (; (word + 1) * 8 <= state->buffered; word++)
+    {
+        const unsigned long long input = list_hash_read64(tail + word * 8);
+        hash ^= list_hash_fold(input ^ secret[(secret_offset + word) % 24], secret[(secret_offset + word + 8) % 24]);
+        hash = (hash << 27 | hash >> 37) * LIST_HASH_PRIME_1;
+    }
+
+    const size_t remaining = state->buffered - word * 8;
+    unsigned long long last = (unsigned long long)remaining << 56;
+    for (size_t i = 0; i < remaining; i++)
+        last |= (unsigned long long)tail[word * 8 + i] << (i * 8);
+    hash ^= list_hash_fold(last ^ secret[(secret_offset + 7) % 24], LIST_HASH_PRIME_2);
+
+    hash ^= hash >> 37;
+    hash *= 0x165667919E3779F9ull;
+    hash ^= hash >> 32;
+    return hash;
+}
+
+unsigned long long list_hash_digest(const ListHashState* state)
+{
+    return list_hash_finish(state, 0, state->total * LIST_HASH_PRIME_1 ^ state->seed);
+}
+
+ListHash128 list_hash_digest128(const ListHashState* state)
+{
+    ListHash128 hash;
+    hash.low = list_hash_finish(state, 0, state->total * LIST_HASH_PRIME_1 ^ state->seed);
+    hash.high = list_hash_finish(state, 11, ~state->total * LIST_HASH_PRIME_2 ^ state->seed);
+    return hash;
+}
+
+unsigned long long list_hash64(const void* list)
+{
+    ListHashState state;
+    list_hash_init(&state, 0);
+    list_hash_sync(&state, list);
+    return list_hash_digest(&state);
+}
+
+ListHash128 list_hash128(const void* list)
+{
+    ListHashState state;
+    list_hash_init(&state, 0);
+    list_hash_sync(&state, list);
+    return list_hash_digest128(&state);
+}
+
+int list_equal(const void* a, const void* b)
+{
+    const ListPrelude* pa = list_prelude(a);
+    const ListPrelude* pb = list_prelude(b);
+    if (pa->stride != pb->stride || pa->length != pb->length)
+        return 0;
+
+    // memcmp is already vectorized by every libc worth using
+    return a == b || memcmp(a, b, pa->length * pa->stride) == 0;
+}
+
+static size_t list_count_separators(const char* buffer, const size_t size, const char separator)
+{
+    size_t count = 0;
+    size_t i = 0;
+
+#if defined(__SSE2__) || defined(_M_X64)
+    const __m128i separators = _mm_set1_epi8(separator);
+    const __m128i newlines = _mm_set1_epi8('\n');
+    for (; i + 16 <= size; i += 16)
+    {
+        const __m128i chunk = _mm_loadu_si128((const __m128i*)(buffer + i));
+        unsigned mask = (unsigned)_mm_movemask_epi8(
+            _mm_or_si128(_mm_cmpeq_epi8(chunk, separators), _mm_cmpeq_epi8(chunk, newlines)));
+        for (; mask; mask &= mask - 1)
+            count++;
+    }
+#endif
+
+    for (; i < size; i++)
+        count += buffer[i] == separator || buffer[i] == '\n';
+    return count;
+}
+
+static int list_is_digit(const char c)
+{
+    return c >= '0' && c <= '9';
+}
+
+// parses up to 8 digits at once when they're all there; only used on little endian hosts
+static int list_parse_eight_digits(const char* p, unsigned long long* value)
+{
+    unsigned long long chunk;
+    memcpy(&chunk, p, sizeof(chunk));
+    if ((chunk & 0xF0F0F0F0F0F0F0F0ull) != 0x3030303030303030ull
+        || ((chunk + 0x0606060606060606ull) & 0xF0F0F0F0F0F0F0F0ull) != 0x3030303030303030ull)
+        return 0;
+
+    chunk = (chunk & 0x0F0F0F0F0F0F0F0Full) * 2561 >> 8;
+    chunk = (chunk & 0x00FF00FF00FF00FFull) * 6553601 >> 16;
+    chunk = (chunk & 0x0000FFFF0000FFFFull) * 42949672960001ull >> 32;
+    *value = chunk;
+    return 1;
+}
+
+// reads decimal digits into `value`, returning how many were read or -1 on overflow
+static long list_parse_digits(const char** cursor, const char* end, unsigned long long* value)
+{
+    const char* p = *cursor;
+    long digits = 0;
+    unsigned long long chunk;
+
+    if (list_host_is_little_endian())
+    {
+        while (end - p >= 8 && digits <= 8 && list_parse_eight_digits(p, &chunk))
+        {
+            if (*value > (~0ull - chunk) / 100000000)
+                return -1;
+            *value = *value * 100000000 + chunk;
+            p += 8;
+            digits += 8;
+        }
+    }
+
+    for (; p < end && list_is_digit(*p); p++, digits++)
+    {
+        const unsigned digit = (unsigned)(*p - '0');
+        if (*value > (~0ull - digit) / 10)
+            return -1;
+        *value = *value * 10 + digit;
+    }
+
+    *cursor = p;
+    return digits;
+}
+
+static const char* list_skip_blanks(const char* p, const char* end, const char separator)
+{
+    while (p < end && *p != separator && (*p == ' ' || *p == '\t' || *p == '\r'))
+        p++;
+    return p;
+}
+
+// moves past the separator after a token, or returns NULL if something else follows it
+static const char* list_end_token(const char* p, const char* end, const char separator)
+{
+    p = list_skip_blanks(p, end, separator);
+    if (p == end)
+        return p;
+    if (*p == separator || *p == '\n')
+        return p + 1;
+    return NULL;
+}
+
+void* list_parse_ints_into(void* list, const size_t stride, const char* buffer, const size_t size,
+    const char separator, size_t* consumed)
+{
+    list_internal_latency_begin(latency_start);
+    if (stride != 1 && stride != 2 && stride != 4 && stride != 8)
+        return list;
+
+    list = list_ensure_capacity(list, list_count_separators(buffer, size, separator) + 1, stride);
+    list_internal_annotate(list, list_len(list), list_cap(list));
+    unsigned char* items = list;
+    size_t length = list_len(list);
+
+    const unsigned long long max = (1ull << (stride * 8 - 1)) - 1;
+    const char* end = buffer + size;
+    const char* p = buffer;
+    const char* stop = end;
+
+    while (p < end)
+    {
+        const char* token = p;
+        p = list_skip_blanks(p, end, separator);
+        if (p < end && (*p == separator || *p == '\n'))
+        {
+            p++;
+            continue;
+        }
+        if (p == end)
+            break;
+
+        const int negative = *p == '-';
+        if (*p == '-' || *p == '+')
+            p++;
+
+        unsigned long long magnitude = 0;
+        const char* next = NULL;
+        if (list_parse_digits(&p, end, &magnitude) > 0 && magnitude <= max + (unsigned)negative)
+            next = list_end_token(p, end, separator);
+        if (!next)
+        {
+            stop = token;
+            break;
+        }
+
+        const long long value = negative ? (long long)(0 - magnitude) : (long long)magnitude;
+        unsigned char* item = items + length * stride;
+        switch (stride)
+        {
+        case 1: *(signed char*)item = (signed char)value; break;
+        case 2: { const short v = (short)value; memcpy(item, &v, sizeof(v)); break; }
+        case 4: { const int v = (int)value; memcpy(item, &v, sizeof(v)); break; }
+        default: memcpy(item, &value, sizeof(value)); break;
+        }
+        length++;
+        p = next;
+    }
+
+    if (consumed)
+        *consumed = (size_t)(stop - buffer);
+
+    list_internal_annotate(list, list_cap(list), length);
+    list_internal_mark_dirty(list, list_len(list), length - list_len(list));
+    list_len(list) = length;
+    list_internal_latency_end(LIST_LATENCY_PARSE, latency_start);
+    return list;
+}
+
+static const double list_exact_powers_of_ten[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22,
+};
+
+static const float list_exact_float_powers_of_ten[] = {
+    1e0f, 1e1f, 1e2f, 1e3f, 1e4f, 1e5f, 1e6f, 1e7f, 1e8f, 1e9f, 1e10f,
+};
+
+// exact when the mantissa and the power of ten are both exactly representable in the item type, so
+// floats are worked out in float rather than rounded twice through a double; otherwise falls back
+// to strtod/strtof. returns the end of the number, or NULL if it isn't one or is out of range.
+static const char* list_parse_float(const char* p, const char* end, const size_t stride, double* result)
+{
+    const char* start = p;
+    const int negative = p < end && *p == '-';
+    if (p < end && (*p == '-' || *p == '+'))
+        p++;
+
+    unsigned long long mantissa = 0;
+    long exponent = 0;
+    long digits = list_parse_digits(&p, end, &mantissa);
+    int exact = digits >= 0;
+    long fraction = 0;
+
+    if (exact && p < end && *p == '.')
+    {
+        p++;
+        const char* fraction_start = p;
+        fraction = list_parse_digits(&p, end, &mantissa);
+        exact = fraction >= 0;
+        exponent = -(long)(p - fraction_start);
+    }
+
+    if (exact && digits + fraction > 0 && p < end && (*p == 'e' || *p == 'E'))
+    {
+        const char* exponent_start = p++;
+        const int negative_exponent = p < end && *p == '-';
+        if (p < end && (*p == '-' || *p == '+'))
+            p++;
+
+        unsigned long long value = 0;
+        const long exponent_digits = list_parse_digits(&p, end, &value);
+        if (exponent_digits <= 0)
+            p = exponent_start;
+        else if (exponent_digits > 5)
+            exact = 0;
+        else
+            exponent += negative_exponent ? -(long)value : (long)value;
+    }
+
+    if (exact && digits + fraction > 0 && stride == sizeof(float))
+    {
+        if (mantissa <= (1ull << 24) && exponent >= -10 && exponent <= 10)
+        {
+            float value = (float)mantissa;
+            value = exponent < 0 ? value / list_exact_float_powers_of_ten[-exponent]
+                                 : value * list_exact_float_powers_of_ten[exponent];
+            *result = negative ? -value : value;
+            return p;
+        }
+    }
+    else if (exact && digits + fraction > 0 && mantissa <= (1ull << 53) && exponent >= -22 && exponent <= 22)
+    {
+        double value = (double)mantissa;
+        value = exponent < 0 ? value / list_exact_powers_of_ten[-exponent] : value * list_exact_powers_of_ten[exponent];
+        *result = negative ? -value : value;
+        return p;
+    }
+
+    // anything else (long mantissas, huge exponents, inf, nan) goes through the C library
+    char token[512];
+    const char* token_end = start;
+    while (token_end < end && (size_t)(token_end - start) < sizeof(token) - 1 && *token_end != '\n'
+        && *token_end != ' ' && *token_end != '\t' && *token_end != '\r')
+        token_end++;
+    memcpy(token, start, (size_t)(token_end - start));
+    token[token_end - start] = '\0';
+
+    char* parsed_end = NULL;
+    errno = 0;
+    *result = stride == sizeof(float) ? strtof(token, &parsed_end) : strtod(token, &parsed_end);
+    if (parsed_end == token || errno == ERANGE)
+        return NULL;
+    return start + (parsed_end - token);
+}
+
+void* list_parse_floats_into(void* list, const size_t stride, const char* buffer, const size_t size,
+    const char separator, size_t* consumed)
+{
+    list_internal_latency_begin(latency_start);
+    if (stride != sizeof(float) && stride != sizeof(double))
+        return list;
+
+    list = list_ensure_capacity(list, list_count_separators(buffer, size, separator) + 1, stride);
+    list_internal_annotate(list, list_len(list), list_cap(list));
+    unsigned char* items = list;
+    size_t length = list_len(list);
+
+    const char* end = buffer + size;
+    const char* p = buffer;
+    const char* stop = end;
+
+    while (p < end)
+    {
+        const char* token = p;
+        p = list_skip_blanks(p, end, separator);
+        if (p < end && (*p == separator || *p == '\n'))
+        {
+            p++;
+            continue;
+        }
+        if (p == end)
+            break;
+
+        double value;
+        p = list_parse_float(p, end, stride, &value);
+        const char* next = p ? list_end_token(p, end, separator) : NULL;
+        if (!next)
+        {
+            stop = token;
+            break;
+        }
+
+        if (stride == sizeof(float))
+        {
+            const float narrow = (float)value;
+            memcpy(items + length * stride, &narrow, sizeof(narrow));
+        }
+        else
+        {
+            memcpy(items + length * stride, &value, sizeof(value));
+        }
+        length++;
+        p = next;
+    }
+
+    if (consumed)
+        *consumed = (size_t)(stop - buffer);
+
+    list_internal_annotate(list, list_cap(list), length);
+    list_internal_mark_dirty(list, list_len(list), length - list_len(list));
+    list_len(list) = length;
+    list_internal_latency_end(LIST_LATENCY_PARSE, latency_start);
+    return list;
+}
+
+#define LIST_DIFF_MAGIC 0x31464649444C44ull // "DLDIFF1"
+
+typedef struct
+{
+    unsigned long long magic;
+    unsigned long long stride;
+    unsigned long long length;
+    unsigned long long block_items;
+} ListDiffHeader;
+
+typedef struct
+{
+    unsigned int sum;
+    unsigned int weighted;
+} ListRollingHash;
+
+static ListRollingHash list_rolling_hash(const unsigned char* data, const size_t size)
+{
+    ListRollingHash hash = {0, 0};
+    for (size_t i = 0; i < size; i++)
+    {
+        hash.sum += data[i];
+        hash.weighted += hash.sum;
+    }
+    return hash;
+}
+
+// slides the window forward by one item: drops `stride` bytes at `out`, takes `stride` bytes at `in`
+static void list_rolling_hash_roll(ListRollingHash* hash, const unsigned char* out, const unsigned char* in,
+    const size_t stride, const size_t window)
+{
+    for (size_t i = 0; i < stride; i++)
+    {
+        hash->sum += (unsigned)in[i] - out[i];
+        hash->weighted += hash->sum - (unsigned)(window * out[i]);
+    }
+}
+
+static size_t list_rolling_hash_slot(const ListRollingHash hash, const size_t mask)
+{
+    const unsigned long long key = ((unsigned long long)hash.weighted << 32 | hash.sum) * 0x9E3779B97F4A7C15ull;
+    return (size_t)(key >> 32) & mask;
+}
+
+typedef struct
+{
+    ListRollingHash hash;
+    size_t block;
+} ListDiffSlot;
+
+// the slot holding `hash`, or the empty slot it would go in
+static size_t list_diff_find(const ListDiffSlot* table, const ListRollingHash hash, const size_t mask)
+{
+    size_t slot = list_rolling_hash_slot(hash, mask);
+    while (table[slot].block && (table[slot].hash.sum != hash.sum || table[slot].hash.weighted != hash.weighted))
+        slot = (slot + 1) & mask;
+    return slot;
+}
+
+static unsigned char* list_put_bytes(unsigned char* out, const void* data, const size_t size)
+{
+    out = list_ensure_capacity(out, size, 1);
+    list_internal_annotate(out, list_len(out), list_len(out) + size);
+    memcpy(out + list_len(out), data, size);
+    list_len(out) += size;
+    return out;
+}
+
+static unsigned char* list_put_op(unsigned char* out, const unsigned char op, const unsigned long long a, const unsigned long long b)
+{
+    unsigned char record[17];
+    record[0] = op;
+    memcpy(record + 1, &a, sizeof(a));
+    memcpy(record + 9, &b, sizeof(b));
+    return list_put_bytes(out, record, op == 'L' ? 9 : sizeof(record));
+}
+
+unsigned char* create_list_diff(const void* a, const void* b, const size_t block_size, Allocator* allocator)
+{
+    list_internal_latency_begin(latency_start);
+    const ListPrelude* pa = list_prelude(a);
+    const ListPrelude* pb = list_prelude(b);
+    if (pa->stride != pb->stride)
+        return NULL;
+    if (allocator == NULL)
+        allocator = &default_allocator;
+
+    const size_t stride = pa->stride;
+    const size_t block_items = block_size / stride ? block_size / stride : 1;
+    const size_t window = block_items * stride;
+    const size_t block_count = pa->length / block_items;
+    const unsigned char* source = a;
+    const unsigned char* target = b;
+
+    // open-addressed table with one entry per distinct rolling hash, holding the first block with
+    // that hash. blocks that share a hash but not their contents hang off it in `chain`, and blocks
+    // equal to one already present are left out, so repeated blocks can't make probing quadratic
+    size_t slots = 16;
+    while (slots < block_count * 2)
+        slots *= 2;
+    const size_t mask = slots - 1;
+
+    ListDiffSlot* table = allocator->alloc(slots * sizeof(ListDiffSlot) + block_count * sizeof(size_t), allocator->context);
+    unsigned char* script = create_list(1, sizeof(ListDiffHeader) + 64, allocator);
+    if (!table || !script)
+    {
+        if (table)
+            allocator->free(table, allocator->context);
+        if (script)
+            list_free(script);
+        return NULL;
+    }
+
+    size_t* chain = (size_t*)(table + slots);
+    memset(table, 0, slots * sizeof(ListDiffSlot) + block_count * sizeof(size_t));
+    for (size_t block = 0; block < block_count; block++)
+    {
+        const ListRollingHash hash = list_rolling_hash(source + block * window, window);
+        size_t slot = list_diff_find(table, hash, mask);
+        if (!table[slot].block)
+        {
+            table[slot].hash = hash;
+            table[slot].block = block + 1;
+            continue;
+        }
+
+        size_t known = table[slot].block;
+        while (known && memcmp(source + (known - 1) * window, source + block * window, window) != 0)
+            known = chain[known - 1];
+        if (!known)
+        {
+            chain[block] = chain[table[slot].block - 1];
+            chain[table[slot].block - 1] = block + 1;
+        }
+    }
+
+    const ListDiffHeader header = {LIST_DIFF_MAGIC, stride, pb->length, block_items};
+    script = list_put_bytes(script, &header, sizeof(header));
+
+    size_t literal_start = 0;
+    size_t copy_first = 0;
+    size_t copy_count = 0;
+    size_t position = 0;
+    int rolling = 0;
+    ListRollingHash hash = {0, 0};
+
+    while (block_count > 0 && position + block_items <= pb->length)
+    {
+        const unsigned char* at = target + position * stride;
+        if (!rolling)
+        {
+            hash = list_rolling_hash(at, window);
+            rolling = 1;
+        }
+
+        // both sides are in memory, so candidates are verified exactly instead of by a strong hash.
+        // the block after a copy is tried first, since that extends the copy instead of starting one
+        size_t match = 0;
+        const size_t next = copy_first + copy_count;
+        if (copy_count > 0 && literal_start == position && next < block_count
+            && memcmp(source + next * window, at, window) == 0)
+            match = next + 1;
+        for (size_t known = match ? 0 : table[list_diff_find(table, hash, mask)].block; known; known = chain[known - 1])
+        {
+            if (memcmp(source + (known - 1) * window, at, window) == 0)
+            {
+                match = known;
+                break;
+            }
+        }
+
+        if (!match)
+        {
+            if (position + block_items < pb->length)
+                list_rolling_hash_roll(&hash, at, at + window, stride, window);
+            position++;
+            continue;
+        }
+
+        const size_t block = match - 1;
+        if (literal_start < position)
+        {
+            if (copy_count > 0)
+                script = list_put_op(script, 'C', copy_first, copy_count);
+            copy_count = 0;
+            script = list_put_op(script, 'L', position - literal_start, 0);
+            script = list_put_bytes(script, target + literal_start * stride, (position - literal_start) * stride);
+        }
+
+        if (copy_count > 0 && block == copy_first + copy_count)
+        {
+            copy_count++;
+        }
+        else
+        {
+            if (copy_count > 0)
+                script = list_put_op(script, 'C', copy_first, copy_count);
+            copy_first = block;
+            copy_count = 1;
+        }
+
+        position += block_items;
+        literal_start = position;
+        rolling = 0;
+    }
+
+    if (copy_count > 0)
+        script = list_put_op(script, 'C', copy_first, copy_count);
+    if (literal_start < pb->length)
+    {
+        script = list_put_op(script, 'L', pb->length - literal_start, 0);
+        script = list_put_bytes(script, target + literal_start * stride, (pb->length - literal_start) * stride);
+    }
+    script = list_put_op(script, 'E', 0, 0);
+
+    allocator->free(table, allocator->context);
+    list_internal_latency_end(LIST_LATENCY_DIFF, latency_start);
+    return script;
+}
+
+void* create_list_patch(const void* a, const unsigned char* script, Allocator* allocator)
+{
+    list_internal_latency_begin(latency_start);
+    const ListPrelude* pa = list_prelude(a);
+    const size_t script_size = list_len(script);
+
+    ListDiffHeader header;
+    if (script_size < sizeof(header))
+        return NULL;
+    memcpy(&header, script, sizeof(header));
+    if (header.magic != LIST_DIFF_MAGIC || header.stride != pa->stride || header.block_items == 0)
+        return NULL;
+
+    const size_t stride = pa->stride;
+    const size_t window = header.block_items * stride;
+    const size_t block_count = pa->length / header.block_items;
+
+    // the header is untrusted, so its length can't be more than the literals in the rest of the
+    // script plus a copy of every block once per copy record could produce
+    const size_t body = script_size - sizeof(header);
+    const size_t copies = body / 17;
+    const size_t copyable = block_count * header.block_items;
+    size_t supply = body / stride;
+    if (copies > 0 && copyable > (SIZE_MAX - supply) / copies)
+        supply = SIZE_MAX;
+    else
+        supply += copies * copyable;
+    if (header.length > supply || header.length > (SIZE_MAX - sizeof(ListPrelude)) / stride)
+        return NULL;
+
+    unsigned char* result = create_list(stride, header.length ? header.length : 1, allocator);
+    if (!result)
+        return NULL;
+    list_internal_annotate(result, 0, header.length);
+
+    size_t cursor = sizeof(header);
+    size_t length = 0;
+    while (cursor < script_size && script[cursor] != 'E')
+    {
+        unsigned long long first = 0;
+        unsigned long long count = 0;
+        const int copy = script[cursor] == 'C';
+        const size_t record = copy ? 17 : 9;
+        if ((!copy && script[cursor] != 'L') || script_size - cursor < record)
+            break;
+
+        memcpy(&first, script + cursor + 1, sizeof(first));
+        if (copy)
+            memcpy(&count, script + cursor + 9, sizeof(count));
+        cursor += record;
+
+        if (copy)
+        {
+            const unsigned long long items = count * header.block_items;
+            if (count > block_count || first > block_count - count || items > header.length - length)
+                break;
+            memcpy(result + length * stride, (const unsigned char*)a + first * window, (size_t)items * stride);
+            length += (size_t)items;
+        }
+        else
+        {
+            if (first > header.length - length || first > (script_size - cursor) / stride)
+                break;
+            memcpy(result + length * stride, script + cursor, (size_t)first * stride);
+            cursor += (size_t)first * stride;
+            length += (size_t)first;
+        }
+    }
+
+    if (cursor >= script_size || script[cursor] != 'E' || length != header.length)
+    {
+        list_free(result);
+        return NULL;
+    }
+
+    list_len(result) = length;
+    list_internal_latency_end(LIST_LATENCY_PATCH, latency_start);
+    return result;
+}
+
+#ifndef DYNAMIC_LIST_WIRE_BLOCK
+#define DYNAMIC_LIST_WIRE_BLOCK 65536
+#endif
+
+#define LIST_WIRE_VERSION 1
+#define LIST_WIRE_HEADER_SIZE 32
+
+void list_byte_swap(void* items, const size_t count, const size_t stride)
+{
+    unsigned char* bytes = items;
+    if (stride != 2 && stride != 4 && stride != 8)
+        return;
+
+    size_t i = 0;
+    const size_t size = count * stride;
+
+#if defined(__AVX2__)
+    const __m256i shuffle = stride == 2
+        ? _mm256_setr_epi8(1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14, 1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14)
+        : stride == 4
+        ? _mm256_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12, 3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12)
+        : _mm256_setr_epi8(7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8);
+    for (; i + 32 <= size; i += 32)
+    {
+        const __m256i chunk = _mm256_loadu_si256((const __m256i*)(bytes + i));
+        _mm256_storeu_si256((__m256i*)(bytes + i), _mm256_shuffle_epi8(chunk, shuffle));
+    }
+#elif defined(__SSSE3__)
+    const __m128i shuffle = stride == 2
+        ? _mm_setr_epi8(1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14)
+        : stride == 4
+        ? _mm_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12)
+        : _mm_setr_epi8(7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8);
+    for (; i + 16 <= size; i += 16)
+    {
+        const __m128i chunk = _mm_loadu_si128((const __m128i*)(bytes + i));
+        _mm_storeu_si128((__m128i*)(bytes + i), _mm_shuffle_epi8(chunk, shuffle));
+    }
+#endif
+
+    for (; i < size; i += stride)
+    {
+        for (size_t low = 0, high = stride - 1; low < high; low++, high--)
+        {
+            const unsigned char swap = bytes[i + low];
+            bytes[i + low] = bytes[i + high];
+            bytes[i + high] = swap;
+        }
+    }
+}
+
+static void list_put_le(unsigned char* out, unsigned long long value, const size_t size)
+{
+    for (size_t i = 0; i < size; i++, value >>= 8)
+        out[i] = (unsigned char)value;
+}
+
+static unsigned long long list_get_le(const unsigned char* in, const size_t size)
+{
+    unsigned long long value = 0;
+    for (size_t i = size; i-- > 0;)
+        value = value << 8 | in[i];
+    return value;
+}
+
+static unsigned long long list_wire_checksum(const unsigned char* data, const size_t size)
+{
+    ListHashState state;
+    list_hash_init(&state, 0);
+    list_hash_update(&state, data, size);
+    return list_hash_digest(&state);
+}
+
+unsigned char* list_wire_encode(const void* list, const int kind, const int flags, Allocator* allocator)
+{
+    list_internal_latency_begin(latency_start);
+    const ListPrelude* prelude = list_prelude(list);
+    const size_t stride = prelude->stride;
+    const size_t block_items = DYNAMIC_LIST_WIRE_BLOCK / stride ? DYNAMIC_LIST_WIRE_BLOCK / stride : 1;
+    const size_t blocks = (prelude->length + block_items - 1) / block_items;
+    const size_t size = LIST_WIRE_HEADER_SIZE + prelude->length * stride
+        + (flags & LIST_WIRE_CHECKSUMS ? blocks * 8 : 0);
+
+    unsigned char* out = create_list(1, size, allocator);
+    if (!out)
+        return NULL;
+    list_internal_annotate(out, 0, size);
+
+    // the header is always little endian; the items stay in the writer's byte order
+    memset(out, 0, LIST_WIRE_HEADER_SIZE);
+    memcpy(out, "DLWF", 4);
+    out[4] = LIST_WIRE_VERSION;
+    out[5] = list_host_is_little_endian() ? 0 : 1;
+    out[6] = (unsigned char)kind;
+    out[7] = (unsigned char)flags;
+    list_put_le(out + 8, stride, 4);
+    list_put_le(out + 12, block_items, 4);
+    list_put_le(out + 16, prelude->length, 8);
+
+    unsigned char* cursor = out + LIST_WIRE_HEADER_SIZE;
+    const unsigned char* items = list;
+    if (!(flags & LIST_WIRE_CHECKSUMS))
+    {
+        memcpy(cursor, items, prelude->length * stride);
+    }
+    else
+    {
+        for (size_t first = 0; first < prelude->length; first += block_items)
+        {
+            const size_t count = prelude->length - first < block_items ? prelude->length - first : block_items;
+            memcpy(cursor, items + first * stride, count * stride);
+            list_put_le(cursor + count * stride, list_wire_checksum(cursor, count * stride), 8);
+            cursor += count * stride + 8;
+        }
+    }
+
+    list_len(out) = size;
+    list_internal_latency_end(LIST_LATENCY_WIRE_ENCODE, latency_start);
+    return out;
+}
+
+void* create_list_from_wire(const unsigned char* data, const size_t size, const size_t stride, Allocator* allocator)
+{
+    list_internal_latency_begin(latency_start);
+    if (size < LIST_WIRE_HEADER_SIZE || memcmp(data, "DLWF", 4) != 0 || data[4] != LIST_WIRE_VERSION)
+        return NULL;
+
+    const int kind = data[6];
+    const int flags = data[7];
+    const size_t block_items = (size_t)list_get_le(data + 12, 4);
+    const unsigned long long length = list_get_le(data + 16, 8);
+    if (list_get_le(data + 8, 4) != stride || block_items == 0 || length > (size - LIST_WIRE_HEADER_SIZE) / stride)
+        return NULL;
+
+    const size_t blocks = ((size_t)length + block_items - 1) / block_items;
+    const size_t checksums = flags & LIST_WIRE_CHECKSUMS ? blocks * 8 : 0;
+    if (size - LIST_WIRE_HEADER_SIZE - (size_t)length * stride != checksums)
+        return NULL;
+
+    // only numbers are swapped; raw items are opaque and stay as they were written
+    const int swap = (data[5] != 0) == list_host_is_little_endian() && kind != LIST_WIRE_RAW;
+
+    unsigned char* list = create_list(stride, length ? (size_t)length : 1, allocator);
+    if (!list)
+        return NULL;
+    list_internal_annotate(list, 0, (size_t)length);
+
+    const unsigned char* cursor = data + LIST_WIRE_HEADER_SIZE;
+    if (!checksums)
+    {
+        memcpy(list, cursor, (size_t)length * stride);
+    }
+    else
+    {
+        for (size_t first = 0; first < length; first += block_items)
+        {
+            const size_t count = (size_t)length - first < block_items ? (size_t)length - first : block_items;
+            if (list_wire_checksum(cursor, count * stride) != list_get_le(cursor + count * stride, 8))
+            {
+                list_free(list);
+                return NULL;
+            }
+            memcpy(list + first * stride, cursor, count * stride);
+            cursor += count * stride + 8;
+        }
+    }
+
+    if (swap)
+        list_byte_swap(list, (size_t)length, stride);
+
+    list_len(list) = (size_t)length;
+    list_internal_latency_end(LIST_LATENCY_WIRE_DECODE, latency_start);
+    return list;
+}
+
+#ifndef DYNAMIC_LIST_MERGE_FANIN
+#define DYNAMIC_LIST_MERGE_FANIN 64
+#endif
+
+#if !defined(DYNAMIC_LIST_NO_THREADS) && !defined(__STDC_NO_THREADS__)
+#define DYNAMIC_LIST_ASYNC_IO
+#include <threads.h>
+#endif
+
+typedef struct
+{
+    FILE* file;
+    unsigned char* buffers[2];
+    size_t counts[2];
+    size_t front;
+    size_t position;
+    int pending;
+} ListRunCursor;
+
+typedef struct
+{
+    ListRunCursor* cursors;
+    size_t cursor_count;
+    size_t buffer_items;
+    size_t stride;
+    int error;
+#ifdef DYNAMIC_LIST_ASYNC_IO
+    thrd_t thread;
+    mtx_t lock;
+    cnd_t work;
+    cnd_t done;
+    size_t* queue;
+    size_t queue_head;
+    size_t queue_count;
+    int stop;
+#endif
+} ListRunReader;
+
+static int list_run_fill(ListRunReader* reader, ListRunCursor* cursor, const size_t buffer)
+{
+    cursor->counts[buffer] = fread(cursor->buffers[buffer], reader->stride, reader->buffer_items, cursor->file);
+    return ferror(cursor->file) ? -1 : 0;
+}
+
+#ifdef DYNAMIC_LIST_ASYNC_IO
+static int list_run_io_thread(void* arg)
+{
+    ListRunReader* reader = arg;
+
+    mtx_lock(&reader->lock);
+    for (;;)
+    {
+        while (reader->queue_count == 0 && !reader->stop)
+            cnd_wait(&reader->work, &reader->lock);
+
+        if (reader->queue_count == 0)
+            break;
+
+        const size_t index = reader->queue[reader->queue_head];
+        reader->queue_head = (reader->queue_head + 1) % reader->cursor_count;
+        reader->queue_count--;
+        mtx_unlock(&reader->lock);
+
+        // the consumer never touches the back buffer while it is pending, so it can be filled
+        // without holding the lock
+        ListRunCursor* cursor = &reader->cursors[index];
+        const int status = list_run_fill(reader, cursor, cursor->front ^ 1);
+
+        mtx_lock(&reader->lock);
+        if (status != 0)
+            reader->error = 1;
+        cursor->pending = 0;
+        cnd_broadcast(&reader->done);
+    }
+    mtx_unlock(&reader->lock);
+
+    return 0;
+}
+#endif
+
+static void list_run_request_refill(ListRunReader* reader, const size_t index)
+{
+    ListRunCursor* cursor = &reader->cursors[index];
+#ifdef DYNAMIC_LIST_ASYNC_IO
+    mtx_lock(&reader->lock);
+    cursor->pending = 1;
+    reader->queue[(reader->queue_head + reader->queue_count) % reader->cursor_count] = index;
+    reader->queue_count++;
+    cnd_signal(&reader->work);
+    mtx_unlock(&reader->lock);
+#else
+    if (list_run_fill(reader, cursor, cursor->front ^ 1) != 0)
+        reader->error = 1;
+#endif
+}
+
+// moves the cursor to its next item, swapping to the back buffer when the front one runs out.
+// returns 0 once the run is exhausted.
+static int list_run_advance(ListRunReader* reader, const size_t index)
+{
+    ListRunCursor* cursor = &reader->cursors[index];
+    if (++cursor->position < cursor->counts[cursor->front])
+        return 1;
+
+#ifdef DYNAMIC_LIST_ASYNC_IO
+    mtx_lock(&reader->lock);
+    while (cursor->pending)
+        cnd_wait(&reader->done, &reader->lock);
+    mtx_unlock(&reader->lock);
+#endif
+
+    cursor->front ^= 1;
+    cursor->position = 0;
+    if (cursor->counts[cursor->front] == 0)
+        return 0;
+
+    list_run_request_refill(reader, index);
+    return 1;
+}
+
+static int list_run_less(const ListRunReader* reader, ListCompareFn compare, const size_t a, const size_t b)
+{
+    const ListRunCursor* ca = &reader->cursors[a];
+    const ListRunCursor* cb = &reader->cursors[b];
+    const int order = compare(
+        ca->buffers[ca->front] + ca->position * reader->stride,
+        cb->buffers[cb->front] + cb->position * reader->stride);
+
+    // ties go to the earlier run so equal items keep their run order
+    return order < 0 || (order == 0 && a < b);
+}
+
+static void list_run_sift_down(const ListRunReader* reader, ListCompareFn compare, size_t* heap, const size_t count, size_t i)
+{
+    for (;;)
+    {
+        size_t smallest = i;
+        const size_t left = i * 2 + 1;
+        const size_t right = left + 1;
+
+        if (left < count && list_run_less(reader, compare, heap[left], heap[smallest]))
+            smallest = left;
+        if (right < count && list_run_less(reader, compare, heap[right], heap[smallest]))
+            smallest = right;
+        if (smallest == i)
+            return;
+
+        const size_t swap = heap[i];
+        heap[i] = heap[smallest];
+        heap[smallest] = swap;
+        i = smallest;
+    }
+}
+
+static int list_merge_runs(FILE** runs, const size_t run_count, const size_t stride, const size_t budget,
+    ListCompareFn compare, ListSinkFn sink, void* context, Allocator* allocator)
+{
+    // the budget is split between two buffers per run plus one output buffer
+    size_t buffer_items = budget / (run_count * 2 + 1);
+    if (buffer_items == 0)
+        buffer_items = 1;
+
+    ListRunReader reader = {0};
+    reader.cursor_count = run_count;
+    reader.buffer_items = buffer_items;
+    reader.stride = stride;
+
+    const size_t buffer_size = buffer_items * stride;
+    const size_t bookkeeping = run_count * (sizeof(ListRunCursor) + sizeof(size_t) * 2);
+    unsigned char* block = allocator->alloc(bookkeeping + buffer_size * (run_count * 2 + 1), allocator->context);
+    if (!block)
+        return -1;
+
+    reader.cursors = (ListRunCursor*)block;
+    size_t* heap = (size_t*)(reader.cursors + run_count);
+#ifdef DYNAMIC_LIST_ASYNC_IO
+    reader.queue = heap + run_count;
+#endif
+    unsigned char* buffers = block + bookkeeping;
+    unsigned char* output = buffers + buffer_size * run_count * 2;
+
+#ifdef DYNAMIC_LIST_ASYNC_IO
+    int started = mtx_init(&reader.lock, mtx_plain) == thrd_success;
+    started = started && cnd_init(&reader.work) == thrd_success;
+    started = started && cnd_init(&reader.done) == thrd_success;
+    started = started && thrd_create(&reader.thread, list_run_io_thread, &reader) == thrd_success;
+    if (!started)
+    {
+        allocator->free(block, allocator->context);
+        return -1;
+    }
+#endif
+
+    size_t heap_count = 0;
+    for (size_t i = 0; i < run_count; i++)
+    {
+        ListRunCursor* cursor = &reader.cursors[i];
+        cursor->file = runs[i];
+        cursor->buffers[0] = buffers + buffer_size * i * 2;
+        cursor->buffers[1] = cursor->buffers[0] + buffer_size;
+        cursor->counts[0] = cursor->counts[1] = 0;
+        cursor->front = 0;
+        cursor->position = 0;
+        cursor->pending = 0;
+
+        rewind(cursor->file);
+        if (list_run_fill(&reader, cursor, 0) != 0)
+            reader.error = 1;
+
+        if (cursor->counts[0] > 0)
+        {
+            heap[heap_count++] = i;
+            list_run_request_refill(&reader, i);
+        }
+    }
+
+    for (size_t i = heap_count / 2; i-- > 0;)
+        list_run_sift_down(&reader, compare, heap, heap_count, i);
+
+    int result = 0;
+    size_t output_count = 0;
+    while (heap_count > 0)
+    {
+        const ListRunCursor* top = &reader.cursors[heap[0]];
+        memcpy(output + output_count * stride, top->buffers[top->front] + top->position * stride, stride);
+
+        if (++output_count == buffer_items)
+        {
+            if (sink(output, output_count, context) != 0)
+            {
+                result = -1;
+                break;
+            }
+            output_count = 0;
+        }
+
+        if (!list_run_advance(&reader, heap[0]))
+            heap[0] = heap[--heap_count];
+        list_run_sift_down(&reader, compare, heap, heap_count, 0);
+    }
+
+    if (result == 0 && output_count > 0 && sink(output, output_count, context) != 0)
+        result = -1;
+
+#ifdef DYNAMIC_LIST_ASYNC_IO
+    mtx_lock(&reader.lock);
+    reader.stop = 1;
+    cnd_signal(&reader.work);
+    mtx_unlock(&reader.lock);
+    thrd_join(reader.thread, NULL);
+    cnd_destroy(&reader.done);
+    cnd_destroy(&reader.work);
+    mtx_destroy(&reader.lock);
+#endif
+
+    if (reader.error)
+        result = -1;
+
+    allocator->free(block, allocator->context);
+    return result;
+}
+
+typedef struct
+{
+    FILE* file;
+    size_t stride;
+} ListFileSink;
+
+static int list_write_sink(const void* items, const size_t count, void* context)
+{
+    const ListFileSink* sink = context;
+    return fwrite(items, sink->stride, count, sink->file) == count ? 0 : -1;
+}
+
+static void list_close_runs(FILE** runs, const size_t count)
+{
+    for (size_t i = 0; i < count; i++)
+        fclose(runs[i]);
+}
+
+// merges the last DYNAMIC_LIST_MERGE_FANIN runs into one while they share a level, so reading a long input
+// keeps fewer than DYNAMIC_LIST_MERGE_FANIN runs open per level instead of one file per run
+static int list_collapse_runs(FILE** runs, size_t* levels, const size_t stride, const size_t budget,
+    ListCompareFn compare, Allocator* allocator)
+{
+    while (list_len(runs) >= DYNAMIC_LIST_MERGE_FANIN)
+    {
+        const size_t count = list_len(runs);
+        const size_t first = count - DYNAMIC_LIST_MERGE_FANIN;
+
+        // levels only fall towards the end, so equal ends mean the whole group is one level
+        if (levels[first] != levels[count - 1])
+            return 0;
+
+        ListFileSink file_sink = {tmpfile(), stride};
+        if (!file_sink.file)
+            return -1;
+        if (list_merge_runs(&runs[first], DYNAMIC_LIST_MERGE_FANIN, stride, budget, compare, list_write_sink,
+            &file_sink, allocator) != 0)
+        {
+            fclose(file_sink.file);
+            return -1;
+        }
+
+        list_close_runs(&runs[first], DYNAMIC_LIST_MERGE_FANIN);
+        runs[first] = file_sink.file;
+        levels[first] += 1;
+
+        list_internal_annotate(runs, count, first + 1);
+        list_internal_annotate(levels, count, first + 1);
+        list_len(runs) = first + 1;
+        list_len(levels) = first + 1;
+    }
+    return 0;
+}
+
+int list_external_sort_stream(FILE* in, const size_t stride, size_t run_capacity, ListCompareFn compare,
+    ListSinkFn sink, void* context, Allocator* allocator)
+{
+    list_internal_latency_begin(latency_start);
+    if (allocator == NULL)
+        allocator = &default_allocator;
+    if (run_capacity == 0)
+        run_capacity = 1;
+
+    FILE** runs = create_list(sizeof(FILE*), DEFAULT_LIST_CAPACITY, allocator);
+    size_t* levels = create_list(sizeof(size_t), DEFAULT_LIST_CAPACITY, allocator);
+    unsigned char* items = create_list(stride, run_capacity, allocator);
+    if (!runs || !levels || !items)
+    {
+        if (runs)
+            list_free(runs);
+        if (levels)
+            list_free(levels);
+        if (items)
+            list_free(items);
+        return -1;
+    }
+
+    // used as a plain buffer, so the whole capacity is made addressable
+    list_internal_annotate(items, 0, run_capacity);
+
+    int result = 0;
+    for (;;)
+    {
+        const size_t count = fread(items, stride, run_capacity, in);
+        if (ferror(in))
+        {
+            result = -1;
+            break;
+        }
+        if (count == 0)
+            break;
+
+        qsort(items, count, stride, compare);
+
+        // everything fit in a single run, so there is nothing to merge
+        if (list_len(runs) == 0 && count < run_capacity)
+        {
+            result = sink(items, count, context) != 0 ? -1 : 0;
+            break;
+        }
+
+        FILE* run = tmpfile();
+        if (!run)
+        {
+            result = -1;
+            break;
+        }
+        list_append(runs, run);
+
+        list_append(levels, (size_t)0);
+
+        if (fwrite(items, stride, count, run) != count)
+        {
+            result = -1;
+            break;
+        }
+        if (list_collapse_runs(runs, levels, stride, run_capacity, compare, allocator) != 0)
+        {
+            result = -1;
+            break;
+        }
+        if (count < run_capacity)
+            break;
+    }
+
+    list_free(items);
+    list_free(levels);
+
+    // merge in passes until the remaining runs fit within the fan-in
+    while (result == 0 && list_len(runs) > DYNAMIC_LIST_MERGE_FANIN)
+    {
+        FILE** merged = create_list(sizeof(FILE*), list_len(runs) / DYNAMIC_LIST_MERGE_FANIN + 1, allocator);
+        if (!merged)
+        {
+            result = -1;
+            break;
+        }
+
+        for (size_t i = 0; i < list_len(runs) && result == 0; i += DYNAMIC_LIST_MERGE_FANIN)
+        {
+            size_t group = list_len(runs) - i;
+            if (group > DYNAMIC_LIST_MERGE_FANIN)
+                group = DYNAMIC_LIST_MERGE_FANIN;
+
+            ListFileSink file_sink = {tmpfile(), stride};
+            if (!file_sink.file)
+            {
+                result = -1;
+                break;
+            }
+            list_append(merged, file_sink.file);
+            result = list_merge_runs(&runs[i], group, stride, run_capacity, compare, list_write_sink, &file_sink, allocator);
+        }
+
+        list_close_runs(runs, list_len(runs));
+        list_free(runs);
+        runs = merged;
+    }
+
+    if (result == 0 && list_len(runs) > 0)
+        result = list_merge_runs(runs, list_len(runs), stride, run_capacity, compare, sink, context, allocator);
+
+    list_close_runs(runs, list_len(runs));
+    list_free(runs);
+    list_internal_latency_end(LIST_LATENCY_SORT, latency_start);
+    return result;
+}
+
+int list_external_sort(FILE* in, FILE* out, const size_t stride, const size_t run_capacity, ListCompareFn compare,
+    Allocator* allocator)
+{
+    ListFileSink sink = {out, stride};
+    return list_external_sort_stream(in, stride, run_capacity, compare, list_write_sink, &sink, allocator);
+}
+
+#ifdef DYNAMIC_LIST_DIRTY_TRACKING
+
+#ifdef _WIN32
+#include <io.h>
+#define list_write_fd _write
+#else
+#include <unistd.h>
+#define list_write_fd write
+#endif
+
+int list_track_dirty(void* list)
+{
+    ListPrelude* prelude = list_prelude(list);
+    if (prelude->dirty)
+        return 0;
+
+    const size_t size = list_dirty_bitmap_size(prelude->capacity, prelude->stride);
+    prelude->dirty = prelude->allocator->alloc(size ? size : 1, prelude->allocator->context);
+    if (!prelude->dirty)
+        return -1;
+
+    // nothing has been checkpointed yet, so the first delta must carry every item
+    memset(prelude->dirty, 0, size);
+    list_mark_dirty(list, 0, prelude->length);
+    return 0;
+}
+
+void list_mark_dirty(void* list, const size_t first, const size_t count)
+{
+    ListPrelude* prelude = list_prelude(list);
+    if (!prelude->dirty || count == 0)
+        return;
+
+    const size_t first_block = first * prelude->stride / DYNAMIC_LIST_DIRTY_BLOCK;
+    const size_t last_block = ((first + count) * prelude->stride - 1) / DYNAMIC_LIST_DIRTY_BLOCK;
+    for (size_t block = first_block; block <= last_block; block++)
+        prelude->dirty[block / 8] |= (unsigned char)(1u << (block % 8));
+}
+
+static int list_write_all(const int fd, const void* data, size_t size)
+{
+    const unsigned char* bytes = data;
+    while (size > 0)
+    {
+        const long written = (long)list_write_fd(fd, bytes, (unsigned)size);
+        if (written <= 0)
+            return -1;
+
+        bytes += written;
+        size -= (size_t)written;
+    }
+
+    return 0;
+}
+
+int list_checkpoint_delta(void* list, const int fd)
+{
+    ListPrelude* prelude = list_prelude(list);
+    if (!prelude->dirty)
+        return -1;
+
+    const unsigned long long header[4] = {
+        0x314B43504C44ull, // "DLPCK1"
+        prelude->stride,
+        prelude->length,
+        DYNAMIC_LIST_DIRTY_BLOCK,
+    };
+    if (list_write_all(fd, header, sizeof(header)) != 0)
+        return -1;
+
+    const unsigned char* items = list;
+    const size_t used = prelude->length * prelude->stride;
+    const size_t blocks = (used + DYNAMIC_LIST_DIRTY_BLOCK - 1) / DYNAMIC_LIST_DIRTY_BLOCK;
+
+    for (size_t block = 0; block < blocks; block++)
+    {
+        if (!prelude->dirty[block / 8])
+        {
+            block |= 7;
+            continue;
+        }
+        if (!(prelude->dirty[block / 8] & (1u << (block % 8))))
+            continue;
+
+        const size_t offset = block * DYNAMIC_LIST_DIRTY_BLOCK;
+        const size_t size = used - offset < DYNAMIC_LIST_DIRTY_BLOCK ? used - offset : DYNAMIC_LIST_DIRTY_BLOCK;
+        const unsigned long long record[2] = {block, size};
+        if (list_write_all(fd, record, sizeof(record)) != 0 || list_write_all(fd, items + offset, size) != 0)
+            return -1;
+    }
+
+    const unsigned long long end[2] = {~0ull, 0};
+    if (list_write_all(fd, end, sizeof(end)) != 0)
+        return -1;
+
+    memset(prelude->dirty, 0, list_dirty_bitmap_size(prelude->capacity, prelude->stride));
+    return 0;
+}
+
+#endif
 
 #endif
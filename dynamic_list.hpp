@@ -0,0 +1,1169 @@
+/*
+    dynamic_list.hpp -- C++ Companion to dynamic_list.h
+
+
+    dynamic_list.h can be included from C++ directly. this header adds adapters for C++17 code, and
+    channels for C++20 code, and needs the implementation of dynamic_list.h compiled in a C file as
+    usual:
+
+        // lists.c
+        #define DYNAMIC_LIST_IMPL
+        #include "dynamic_list.h"
+
+
+    Polymorphic Memory Resources
+    ============================
+    --- to make lists from a std::pmr::memory_resource:
+
+            std::pmr::monotonic_buffer_resource arena;
+            dynamic_list::resource_allocator allocator(&arena);
+            int* list = list_new_alloc(int, allocator.get());
+
+        every block carries a small header holding its size, since the Allocator interface doesn't
+        pass one to free. the resource_allocator has to outlive its lists, and can't be copied or
+        moved because the Allocator points back at it. exceptions thrown by the resource are turned
+        into NULL.
+
+        with a monotonic resource, lists can be dropped along with the arena instead of freed one by
+        one - unless DYNAMIC_LIST_TRACK_SITES is defined, which keeps every live list in a registry
+        until list_free is called. with DYNAMIC_LIST_ACCOUNTING, list_allocator_stats then also keeps
+        counting them as live.
+
+    --- to back PMR containers with an Allocator:
+
+            dynamic_list::allocator_resource resource(&allocator);
+            std::pmr::vector<int> values(&resource);
+
+        a null Allocator uses the default one. alignments above alignof(max_align_t) are met by
+        over-allocating. two allocator_resources compare equal when they wrap the same Allocator.
+
+    --- to share one arena per request between lists and containers:
+
+            std::pmr::monotonic_buffer_resource arena;
+            dynamic_list::resource_allocator allocator(&arena);
+            dynamic_list::allocator_resource resource(allocator.get());
+
+        where the second adapter is only needed by code that is handed an Allocator and has to make
+        containers from it.
+
+
+    Static Lists
+    ============
+    --- to keep up to N items inline, with no allocator:
+
+            dynamic_list::static_list<int, 64> list;
+            list.append(10);
+            for (int value : list)
+                std::printf("%d\n", value);
+
+        append returns a pointer to the new item, or nullptr when the list is full. remove_at moves
+        the last item into the gap, like list_remove_at. every member is constexpr, so a
+        static_list can be filled and read at compile time. items must be trivially copyable and
+        default constructible.
+
+        list() returns a pointer laid out like a heap list, which can be passed to anything that
+        only reads a list (list_len, list_hash64, list_wire_encode...), but never to something that
+        grows or frees one.
+
+
+    Non-Trivial Items
+    =================
+    --- to keep items with constructors and destructors in a list:
+
+            std::string* names = list_new(std::string);
+            dynamic_list::emplace_back(names, 32, 'x');
+            dynamic_list::remove_at(names, 0);
+            dynamic_list::destroy(names);
+
+        emplace_back constructs the item in place, in the list's spare capacity, and returns a
+        pointer to it. pop_back, remove_at, clear and destroy run the destructors that list_pop_back,
+        list_remove_at, list_clear and list_free would skip. the C macros that copy items
+        (list_append, list_remove_at, list_pop_back...) must not be used on these lists.
+
+        growing uses realloc when the item type is trivially relocatable, meaning an item can be
+        moved with memcpy and its old bytes dropped without running its destructor. otherwise the
+        items are move constructed into a new block and destroyed in the old one, which needs a
+        noexcept move constructor. trivially copyable types are trivially relocatable; other types
+        opt in with:
+
+            template <>
+            struct dynamic_list::is_trivially_relocatable<Handle> : std::true_type {};
+
+        a type that points into itself, like libstdc++'s std::string with its inline buffer, must
+        not opt in.
+
+
+    Executors
+    =========
+    --- to run jobs on the calling thread:
+
+            dynamic_list::inline_executor executor;
+            executor.post(job, &state);
+            executor.run();
+
+        run keeps going until the queue is empty, including jobs posted by the jobs it runs, and
+        returns how many it ran. an inline_executor must only be used from one thread.
+
+    --- to run jobs on a pool of threads:
+
+            dynamic_list::thread_pool_executor executor(4);
+            executor.post(job, &state);
+            executor.wait();
+
+        wait blocks until the queue is empty and no job is running. the destructor runs whatever is
+        still queued before joining the threads. without an argument, the pool has a thread per
+        hardware thread.
+
+        both queue jobs as a function and an argument in a list, so posting doesn't allocate once the
+        queue has grown to its working size.
+
+
+    Ranges
+    ======
+    --- to use a list with range algorithms:
+
+            std::ranges::sort(dynamic_list::view(list));
+            std::span<int> items = dynamic_list::view(list);
+
+        a list_view reads the length when begin, end or size is called, so it follows appends, but a
+        list that grows moves, and a view made before that points at the old items. its iterators are
+        plain pointers, so it is a contiguous range, and the standard algorithms with execution
+        policies take it too. the span conversion needs C++20.
+
+    --- to sort, transform or fold a list on a thread pool:
+
+            dynamic_list::thread_pool_executor executor;
+            dynamic_list::parallel_sort(executor, list);
+            dynamic_list::parallel_transform(executor, list, out, [](int value) { return value * 2; });
+            long long sum = dynamic_list::parallel_reduce(executor, list, 0LL);
+
+        parallel_sort sorts one piece per thread and merges them pairwise. parallel_transform writes
+        fn(list[i]) to out[i], where out can be list itself, or any list at least as long.
+        parallel_reduce folds chunks of items starting from their first item, then folds the results
+        in order into init, so the operation has to be associative and the items convertible to the
+        result type. all three mark what they write dirty with DYNAMIC_LIST_DIRTY_TRACKING.
+
+        they're built on parallel_for, which calls fn(begin, end) over chunks of [0, count):
+
+            dynamic_list::parallel_for(executor, count, [&](std::size_t begin, std::size_t end) {
+                // ...
+            });
+
+        the calling thread takes chunks too, and returns once all of them are done. the first
+        exception thrown by fn is rethrown there, and the chunks not yet started are skipped. these
+        must not be called from a job running on the same pool, since the pool could then end up
+        with every thread waiting.
+
+
+    Channels
+    ========
+    --- to hand items between coroutines, with C++20:
+
+            dynamic_list::thread_pool_executor executor;
+            dynamic_list::channel<int> channel(1024, executor);
+
+            dynamic_list::task produce(dynamic_list::channel<int>& channel)
+            {
+                int batch[64];
+                // ...
+                co_await channel.send_many(batch, 64);
+                channel.close();
+            }
+
+            dynamic_list::task consume(dynamic_list::channel<int>& channel)
+            {
+                int batch[64];
+                while (std::size_t count = co_await channel.recv_many(batch, 64))
+                    // ...
+            }
+
+            produce(channel).start(executor);
+            consume(channel).start(executor);
+            executor.wait();
+
+        the buffer is a list of the given capacity, made with the Allocator passed after the
+        executor. send_many suspends until every item is in the buffer, and returns how many were
+        sent - fewer only when the channel is closed. recv_many suspends until at least one item is
+        buffered, and returns up to max of them, or 0 once the channel is closed and drained.
+
+        a suspended coroutine is resumed on the channel's executor once the other side has moved its
+        whole batch: items are copied into a waiting receiver, or out of a waiting sender, by the
+        coroutine that makes room for them. a stage handing over 64 items at a time so wakes its peer
+        once per batch rather than once per item.
+
+        the executor type is the second template argument, so a pipeline kept on one thread is a
+        channel<int, dynamic_list::inline_executor>. items must be trivially copyable. a channel must
+        outlive the coroutines waiting on it.
+
+        a task starts suspended, runs on the executor passed to start, and frees itself when it
+        returns. an exception escaping a task terminates the program.
+
+
+    License
+    =======
+    Copyright 2024 dresswithpockets (dresswithpockets@pm.me)
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <memory_resource>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#if __cplusplus >= 202002L && __has_include(<span>)
+#define DYNAMIC_LIST_SPAN
+#include <ranges>
+#include <span>
+#endif
+
+#if defined(__cpp_impl_coroutine) && __has_include(<coroutine>)
+#define DYNAMIC_LIST_COROUTINES
+#include <coroutine>
+#endif
+
+#include "dynamic_list.h"
+
+namespace dynamic_list
+{
+
+template <class T, std::size_t N>
+class static_list
+{
+    static_assert(std::is_trivially_copyable_v<T> && std::is_default_constructible_v<T>,
+        "static_list items are copied with memcpy by the list functions");
+    static_assert(alignof(T) <= alignof(ListPrelude), "items can't be aligned beyond max_align_t");
+    static_assert(N > 0, "a static_list needs room for at least one item");
+
+public:
+    constexpr static_list() noexcept : prelude_{}, items_{}
+    {
+        prelude_.capacity = N;
+        prelude_.stride = sizeof(T);
+    }
+
+    static constexpr std::size_t capacity() noexcept { return N; }
+    constexpr std::size_t size() const noexcept { return prelude_.length; }
+    constexpr bool empty() const noexcept { return prelude_.length == 0; }
+    constexpr bool full() const noexcept { return prelude_.length == N; }
+
+    constexpr T* append(const T& item) noexcept
+    {
+        if (prelude_.length == N)
+            return nullptr;
+        items_[prelude_.length] = item;
+        return &items_[prelude_.length++];
+    }
+
+    constexpr void remove_at(std::size_t index) noexcept
+    {
+        if (index < prelude_.length)
+            items_[index] = items_[--prelude_.length];
+    }
+
+    constexpr void pop_back() noexcept { prelude_.length -= 1; }
+    constexpr void clear() noexcept { prelude_.length = 0; }
+
+    constexpr T& operator[](std::size_t index) noexcept { return items_[index]; }
+    constexpr const T& operator[](std::size_t index) const noexcept { return items_[index]; }
+
+    constexpr T* data() noexcept { return items_; }
+    constexpr const T* data() const noexcept { return items_; }
+    constexpr T* begin() noexcept { return items_; }
+    constexpr const T* begin() const noexcept { return items_; }
+    constexpr T* end() noexcept { return items_ + prelude_.length; }
+    constexpr const T* end() const noexcept { return items_ + prelude_.length; }
+
+    // the prelude is directly in front of the items, so this is a list the C functions can read
+    T* list() noexcept { return items_; }
+    const T* list() const noexcept { return items_; }
+
+private:
+    ListPrelude prelude_;
+    T items_[N];
+};
+
+template <class T>
+struct is_trivially_relocatable : std::is_trivially_copyable<T>
+{
+};
+
+template <class T>
+inline constexpr bool is_trivially_relocatable_v = is_trivially_relocatable<T>::value;
+
+namespace detail
+{
+template <class T>
+void relocate(void* to, void* from, std::size_t count) noexcept
+{
+    T* source = static_cast<T*>(from);
+    T* target = static_cast<T*>(to);
+    for (std::size_t i = 0; i < count; i++)
+    {
+        ::new (static_cast<void*>(target + i)) T(std::move(source[i]));
+        source[i].~T();
+    }
+}
+}
+
+template <class T>
+T* ensure_capacity(T* list, std::size_t count)
+{
+    T* grown;
+    if constexpr (is_trivially_relocatable_v<T>)
+    {
+        grown = static_cast<T*>(list_ensure_capacity(list, count, sizeof(T)));
+    }
+    else
+    {
+        static_assert(std::is_nothrow_move_constructible_v<T>,
+            "items that aren't trivially relocatable are moved by a noexcept move constructor when the list grows");
+        grown = static_cast<T*>(list_ensure_capacity_relocate(list, count, sizeof(T), detail::relocate<T>));
+    }
+
+    // the list is left as it was when the new block can't be allocated
+    if (!grown)
+        throw std::bad_alloc();
+    return grown;
+}
+
+template <class T, class... Args>
+T* emplace_back(T*& list, Args&&... args)
+{
+    list = ensure_capacity(list, 1);
+    ListPrelude* prelude = list_prelude(list);
+    list_internal_annotate(list, prelude->length, prelude->length + 1);
+
+    T* item;
+    try
+    {
+        item = ::new (static_cast<void*>(list + prelude->length)) T(std::forward<Args>(args)...);
+    }
+    catch (...)
+    {
+        list_internal_annotate(list, prelude->length + 1, prelude->length);
+        throw;
+    }
+
+    list_internal_mark_dirty(list, prelude->length, 1);
+    prelude->length++;
+    return item;
+}
+
+template <class T>
+void pop_back(T* list) noexcept
+{
+    list[list_len(list) - 1].~T();
+    list_pop_back(list);
+}
+
+template <class T>
+void remove_at(T* list, std::size_t index)
+{
+    const std::size_t last = list_len(list) - 1;
+    if (index > last)
+        return;
+
+    if (index != last)
+    {
+        list[index] = std::move(list[last]);
+        list_internal_mark_dirty(list, index, 1);
+    }
+    pop_back(list);
+}
+
+template <class T>
+void clear(T* list) noexcept
+{
+    std::destroy(list, list + list_len(list));
+    list_clear(list);
+}
+
+template <class T>
+void destroy(T* list) noexcept
+{
+    std::destroy(list, list + list_len(list));
+    list_free(list);
+}
+
+template <class T>
+class list_view
+{
+public:
+    explicit list_view(T* list) noexcept : list_(list) {}
+
+    T* begin() const noexcept { return list_; }
+    T* end() const noexcept { return list_ + list_len(list_); }
+    T* data() const noexcept { return list_; }
+    std::size_t size() const noexcept { return list_len(list_); }
+    bool empty() const noexcept { return list_len(list_) == 0; }
+    T& operator[](std::size_t index) const noexcept { return list_[index]; }
+
+#ifdef DYNAMIC_LIST_SPAN
+    operator std::span<T>() const noexcept { return std::span<T>(list_, list_len(list_)); }
+#endif
+
+private:
+    T* list_;
+};
+
+template <class T>
+list_view<T> view(T* list) noexcept
+{
+    return list_view<T>(list);
+}
+
+class resource_allocator
+{
+public:
+    explicit resource_allocator(std::pmr::memory_resource* resource = std::pmr::get_default_resource()) noexcept
+        : allocator_{}, resource_(resource)
+    {
+        allocator_.alloc = alloc;
+        allocator_.realloc = realloc;
+        allocator_.free = free;
+        allocator_.context = this;
+    }
+
+    resource_allocator(const resource_allocator&) = delete;
+    resource_allocator& operator=(const resource_allocator&) = delete;
+
+    Allocator* get() noexcept { return &allocator_; }
+    std::pmr::memory_resource* resource() const noexcept { return resource_; }
+
+private:
+    // keeps the blocks it returns aligned like malloc's
+    static constexpr std::size_t header = alignof(std::max_align_t);
+
+    static std::size_t size_of(void* ptr) noexcept
+    {
+        std::size_t size;
+        std::memcpy(&size, static_cast<unsigned char*>(ptr) - header, sizeof(size));
+        return size;
+    }
+
+    static void* alloc(std::size_t size, void* context) noexcept
+    {
+        auto* self = static_cast<resource_allocator*>(context);
+        try
+        {
+            auto* base = static_cast<unsigned char*>(self->resource_->allocate(header + size, header));
+            std::memcpy(base, &size, sizeof(size));
+            return base + header;
+        }
+        catch (...)
+        {
+            return nullptr;
+        }
+    }
+
+    static void* realloc(void* ptr, std::size_t size, void* context) noexcept
+    {
+        const std::size_t old_size = size_of(ptr);
+        void* block = alloc(size, context);
+        if (block)
+        {
+            std::memcpy(block, ptr, old_size < size ? old_size : size);
+            free(ptr, context);
+        }
+        return block;
+    }
+
+    static void free(void* ptr, void* context) noexcept
+    {
+        auto* self = static_cast<resource_allocator*>(context);
+        self->resource_->deallocate(static_cast<unsigned char*>(ptr) - header, header + size_of(ptr), header);
+    }
+
+    Allocator allocator_;
+    std::pmr::memory_resource* resource_;
+};
+
+class allocator_resource : public std::pmr::memory_resource
+{
+public:
+    explicit allocator_resource(Allocator* allocator = nullptr) noexcept
+        : default_{}, allocator_(allocator)
+    {
+        if (!allocator_)
+        {
+            default_.alloc = default_allocator_alloc;
+            default_.realloc = default_allocator_realloc;
+            default_.free = default_allocator_free;
+            allocator_ = &default_;
+        }
+    }
+
+    allocator_resource(const allocator_resource&) = delete;
+    allocator_resource& operator=(const allocator_resource&) = delete;
+
+    Allocator* allocator() const noexcept { return allocator_; }
+
+protected:
+    void* do_allocate(std::size_t bytes, std::size_t alignment) override
+    {
+        if (alignment <= alignof(std::max_align_t))
+        {
+            void* block = allocator_->alloc(bytes ? bytes : 1, allocator_->context);
+            if (!block)
+                throw std::bad_alloc();
+            return block;
+        }
+
+        // the block the Allocator returned is kept just in front of the aligned pointer
+        auto* base = static_cast<unsigned char*>(allocator_->alloc(bytes + alignment + sizeof(void*), allocator_->context));
+        if (!base)
+            throw std::bad_alloc();
+
+        const auto address = reinterpret_cast<std::uintptr_t>(base + sizeof(void*));
+        auto* aligned = reinterpret_cast<unsigned char*>((address + alignment - 1) & ~(std::uintptr_t)(alignment - 1));
+        std::memcpy(aligned - sizeof(void*), &base, sizeof(base));
+        return aligned;
+    }
+
+    void do_deallocate(void* ptr, std::size_t, std::size_t alignment) override
+    {
+        if (alignment > alignof(std::max_align_t))
+            std::memcpy(&ptr, static_cast<unsigned char*>(ptr) - sizeof(void*), sizeof(ptr));
+        allocator_->free(ptr, allocator_->context);
+    }
+
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override
+    {
+        const auto* resource = dynamic_cast<const allocator_resource*>(&other);
+        return resource && resource->allocator_ == allocator_;
+    }
+
+private:
+    Allocator default_;
+    Allocator* allocator_;
+};
+
+
+class inline_executor
+{
+public:
+    inline_executor() : jobs_(list_new(job)), head_(0)
+    {
+        if (!jobs_)
+            throw std::bad_alloc();
+    }
+
+    ~inline_executor() { list_free(jobs_); }
+
+    inline_executor(const inline_executor&) = delete;
+    inline_executor& operator=(const inline_executor&) = delete;
+
+    void post(void (*run)(void*), void* argument) { list_append(jobs_, (job{run, argument})); }
+
+    std::size_t run()
+    {
+        std::size_t ran = 0;
+        while (head_ < list_len(jobs_))
+        {
+            // copied out first, since the job can post more and move the queue
+            const job next = jobs_[head_++];
+            compact();
+            next.run(next.argument);
+            ran++;
+        }
+        return ran;
+    }
+
+private:
+    struct job
+    {
+        void (*run)(void*);
+        void* argument;
+    };
+
+    // drops the jobs already taken once they're half the queue, so a queue that jobs keep posting
+    // to doesn't grow without bound
+    void compact()
+    {
+        const std::size_t length = list_len(jobs_);
+        if (head_ * 2 < length)
+            return;
+        std::memmove(jobs_, jobs_ + head_, (length - head_) * sizeof(job));
+        list_internal_annotate(jobs_, length, length - head_);
+        list_len(jobs_) = length - head_;
+        head_ = 0;
+    }
+
+    job* jobs_;
+    std::size_t head_;
+};
+
+class thread_pool_executor
+{
+public:
+    explicit thread_pool_executor(std::size_t threads = std::thread::hardware_concurrency())
+        : jobs_(list_new(job)), head_(0), busy_(0), stopping_(false)
+    {
+        if (!jobs_)
+            throw std::bad_alloc();
+        if (threads == 0)
+            threads = 1;
+
+        threads_.reserve(threads);
+        for (std::size_t i = 0; i < threads; i++)
+            threads_.emplace_back([this] { work(); });
+    }
+
+    ~thread_pool_executor()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopping_ = true;
+        }
+        available_.notify_all();
+        for (std::thread& thread : threads_)
+            thread.join();
+        list_free(jobs_);
+    }
+
+    thread_pool_executor(const thread_pool_executor&) = delete;
+    thread_pool_executor& operator=(const thread_pool_executor&) = delete;
+
+    std::size_t size() const noexcept { return threads_.size(); }
+
+    void post(void (*run)(void*), void* argument)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            list_append(jobs_, (job{run, argument}));
+        }
+        available_.notify_one();
+    }
+
+    void wait()
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        idle_.wait(lock, [this] { return head_ == list_len(jobs_) && busy_ == 0; });
+    }
+
+private:
+    struct job
+    {
+        void (*run)(void*);
+        void* argument;
+    };
+
+    void work()
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        for (;;)
+        {
+            available_.wait(lock, [this] { return stopping_ || head_ < list_len(jobs_); });
+            if (head_ == list_len(jobs_))
+                return;
+
+            const job next = jobs_[head_++];
+            compact();
+
+            busy_++;
+            lock.unlock();
+            next.run(next.argument);
+            lock.lock();
+            busy_--;
+
+            if (head_ == list_len(jobs_) && busy_ == 0)
+                idle_.notify_all();
+        }
+    }
+
+    // same as inline_executor::compact, called with the lock held
+    void compact()
+    {
+        const std::size_t length = list_len(jobs_);
+        if (head_ * 2 < length)
+            return;
+        std::memmove(jobs_, jobs_ + head_, (length - head_) * sizeof(job));
+        list_internal_annotate(jobs_, length, length - head_);
+        list_len(jobs_) = length - head_;
+        head_ = 0;
+    }
+
+    job* jobs_;
+    std::size_t head_;
+    std::size_t busy_;
+    bool stopping_;
+    std::mutex mutex_;
+    std::condition_variable available_;
+    std::condition_variable idle_;
+    std::vector<std::thread> threads_;
+};
+
+namespace detail
+{
+// splits [0, count) into chunks taken in turn by the pool and by the calling thread, which waits
+// until every job it posted has returned, since they all point at this state
+template <class Fn>
+struct fork_join
+{
+    Fn& fn;
+    std::size_t count;
+    std::size_t chunk;
+    std::size_t chunks;
+    std::atomic<std::size_t> next;
+    std::size_t pending;
+    std::exception_ptr error;
+    std::mutex mutex;
+    std::condition_variable done;
+
+    void work() noexcept
+    {
+        for (;;)
+        {
+            const std::size_t index = next.fetch_add(1, std::memory_order_relaxed);
+            if (index >= chunks)
+                return;
+
+            const std::size_t begin = index * chunk;
+            try
+            {
+                fn(begin, std::min(count, begin + chunk));
+            }
+            catch (...)
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (!error)
+                    error = std::current_exception();
+                // the remaining chunks are skipped
+                next.store(chunks, std::memory_order_relaxed);
+            }
+        }
+    }
+
+    static void job(void* argument) noexcept
+    {
+        auto* self = static_cast<fork_join*>(argument);
+        self->work();
+
+        std::lock_guard<std::mutex> lock(self->mutex);
+        if (--self->pending == 0)
+            self->done.notify_one();
+    }
+};
+}
+
+template <class Fn>
+void parallel_for(thread_pool_executor& executor, std::size_t count, Fn&& fn, std::size_t grain = 1)
+{
+    if (count == 0)
+        return;
+
+    // a few chunks per thread, so a slow one doesn't hold up the rest
+    std::size_t chunk = (count + executor.size() * 4 - 1) / (executor.size() * 4);
+    if (chunk < grain)
+        chunk = grain;
+
+    detail::fork_join<std::remove_reference_t<Fn>> state{fn, count, chunk, (count + chunk - 1) / chunk, {0}, 0, nullptr, {}, {}};
+    state.pending = std::min(state.chunks - 1, executor.size());
+    for (std::size_t i = 0, jobs = state.pending; i < jobs; i++)
+        executor.post(decltype(state)::job, &state);
+
+    state.work();
+    {
+        std::unique_lock<std::mutex> lock(state.mutex);
+        state.done.wait(lock, [&state] { return state.pending == 0; });
+    }
+    if (state.error)
+        std::rethrow_exception(state.error);
+}
+
+template <class T, class Compare = std::less<>>
+void parallel_sort(thread_pool_executor& executor, T* list, Compare compare = Compare())
+{
+    const std::size_t length = list_len(list);
+    std::size_t pieces = executor.size() * 2;
+    if (length / pieces < 4096)
+        pieces = length / 4096 + 1;
+
+    const auto bound = [length, pieces](std::size_t piece) {
+        return length / pieces * piece + length % pieces * piece / pieces;
+    };
+
+    parallel_for(executor, pieces, [&](std::size_t begin, std::size_t end) {
+        for (std::size_t piece = begin; piece < end; piece++)
+            std::sort(list + bound(piece), list + bound(piece + 1), compare);
+    });
+
+    // sorted runs are merged pairwise, halving their number every round
+    for (std::size_t width = 1; width < pieces; width *= 2)
+    {
+        parallel_for(executor, (pieces + width * 2 - 1) / (width * 2), [&](std::size_t begin, std::size_t end) {
+            for (std::size_t pair = begin; pair < end; pair++)
+            {
+                const std::size_t first = pair * width * 2;
+                const std::size_t middle = std::min(first + width, pieces);
+                const std::size_t last = std::min(first + width * 2, pieces);
+                std::inplace_merge(list + bound(first), list + bound(middle), list + bound(last), compare);
+            }
+        });
+    }
+
+    list_internal_mark_dirty(list, 0, length);
+}
+
+template <class T, class U, class Fn>
+void parallel_transform(thread_pool_executor& executor, const T* list, U* out, Fn fn)
+{
+    const std::size_t length = list_len(list);
+    parallel_for(executor, length, [&](std::size_t begin, std::size_t end) {
+        for (std::size_t i = begin; i < end; i++)
+            out[i] = fn(list[i]);
+    }, 1024);
+
+    list_internal_mark_dirty(out, 0, length);
+}
+
+template <class T, class R, class Op = std::plus<>>
+R parallel_reduce(thread_pool_executor& executor, const T* list, R init, Op op = Op())
+{
+    const std::size_t length = list_len(list);
+    const std::size_t chunk = 1024;
+    std::vector<R> partials((length + chunk - 1) / chunk);
+
+    // each chunk is folded on its own, then the partial results are folded in order
+    parallel_for(executor, partials.size(), [&](std::size_t begin, std::size_t end) {
+        for (std::size_t i = begin; i < end; i++)
+        {
+            const T* item = list + i * chunk;
+            const T* last = list + std::min(length, (i + 1) * chunk);
+            R partial = *item++;
+            for (; item < last; item++)
+                partial = op(std::move(partial), *item);
+            partials[i] = std::move(partial);
+        }
+    });
+
+    for (R& partial : partials)
+        init = op(std::move(init), std::move(partial));
+    return init;
+}
+
+#ifdef DYNAMIC_LIST_COROUTINES
+namespace detail
+{
+inline void resume(void* address)
+{
+    std::coroutine_handle<>::from_address(address).resume();
+}
+}
+
+class task
+{
+public:
+    struct promise_type
+    {
+        task get_return_object() noexcept { return task(std::coroutine_handle<promise_type>::from_promise(*this)); }
+        std::suspend_always initial_suspend() const noexcept { return {}; }
+        std::suspend_never final_suspend() const noexcept { return {}; }
+        void return_void() const noexcept {}
+        void unhandled_exception() const noexcept { std::terminate(); }
+    };
+
+    task(task&& other) noexcept : handle_(std::exchange(other.handle_, nullptr)) {}
+    task& operator=(task&&) = delete;
+
+    ~task()
+    {
+        if (handle_)
+            handle_.destroy();
+    }
+
+    template <class Executor>
+    void start(Executor& executor) &&
+    {
+        executor.post(detail::resume, std::exchange(handle_, nullptr).address());
+    }
+
+private:
+    explicit task(std::coroutine_handle<promise_type> handle) noexcept : handle_(handle) {}
+
+    std::coroutine_handle<promise_type> handle_;
+};
+
+template <class T, class Executor = thread_pool_executor>
+class channel
+{
+    static_assert(std::is_trivially_copyable_v<T>, "channel items are copied with memcpy");
+
+    // lives in the awaiting coroutine's frame while it is suspended
+    struct waiter
+    {
+        waiter* next;
+        std::coroutine_handle<> handle;
+        const T* in;
+        T* out;
+        std::size_t count;
+        std::size_t done;
+    };
+
+    struct waiter_queue
+    {
+        waiter* head = nullptr;
+        waiter* tail = nullptr;
+
+        void push(waiter* item) noexcept
+        {
+            item->next = nullptr;
+            if (tail)
+                tail->next = item;
+            else
+                head = item;
+            tail = item;
+        }
+
+        waiter* pop() noexcept
+        {
+            waiter* item = head;
+            head = item->next;
+            if (!head)
+                tail = nullptr;
+            return item;
+        }
+    };
+
+public:
+    class send_awaiter
+    {
+    public:
+        bool await_ready() const noexcept { return waiter_.count == 0; }
+
+        bool await_suspend(std::coroutine_handle<> handle)
+        {
+            waiter_.handle = handle;
+            return channel_.suspend_sender(waiter_);
+        }
+
+        std::size_t await_resume() const noexcept { return waiter_.done; }
+
+    private:
+        friend channel;
+
+        send_awaiter(channel& owner, const T* items, std::size_t count) noexcept
+            : channel_(owner), waiter_{nullptr, nullptr, items, nullptr, count, 0}
+        {
+        }
+
+        channel& channel_;
+        waiter waiter_;
+    };
+
+    class recv_awaiter
+    {
+    public:
+        bool await_ready() const noexcept { return waiter_.count == 0; }
+
+        bool await_suspend(std::coroutine_handle<> handle)
+        {
+            waiter_.handle = handle;
+            return channel_.suspend_receiver(waiter_);
+        }
+
+        std::size_t await_resume() const noexcept { return waiter_.done; }
+
+    private:
+        friend channel;
+
+        recv_awaiter(channel& owner, T* items, std::size_t max) noexcept
+            : channel_(owner), waiter_{nullptr, nullptr, nullptr, items, max, 0}
+        {
+        }
+
+        channel& channel_;
+        waiter waiter_;
+    };
+
+    channel(std::size_t capacity, Executor& executor, Allocator* allocator = nullptr)
+        : executor_(executor), buffer_(static_cast<T*>(create_list(sizeof(T), capacity ? capacity : 1, allocator))),
+          capacity_(capacity ? capacity : 1), head_(0), count_(0), closed_(false)
+    {
+        if (!buffer_)
+            throw std::bad_alloc();
+        // the ring wraps around the whole capacity, so all of it is in use as far as the list goes
+        (void)list_resize(buffer_, capacity_);
+    }
+
+    ~channel() { list_free(buffer_); }
+
+    channel(const channel&) = delete;
+    channel& operator=(const channel&) = delete;
+
+    std::size_t capacity() const noexcept { return capacity_; }
+
+    send_awaiter send_many(const T* items, std::size_t count) noexcept { return send_awaiter(*this, items, count); }
+    recv_awaiter recv_many(T* items, std::size_t max) noexcept { return recv_awaiter(*this, items, max); }
+
+    void close()
+    {
+        waiter* ready = nullptr;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            closed_ = true;
+            while (senders_.head)
+                ready = chain(ready, senders_.pop());
+            while (receivers_.head)
+                ready = chain(ready, receivers_.pop());
+        }
+        wake(ready);
+    }
+
+private:
+    static waiter* chain(waiter* ready, waiter* item) noexcept
+    {
+        item->next = ready;
+        return item;
+    }
+
+    std::size_t push(const T* items, std::size_t count) noexcept
+    {
+        if (count > capacity_ - count_)
+            count = capacity_ - count_;
+
+        std::size_t tail = (head_ + count_) % capacity_;
+        const std::size_t first = count < capacity_ - tail ? count : capacity_ - tail;
+        std::memcpy(buffer_ + tail, items, first * sizeof(T));
+        std::memcpy(buffer_, items + first, (count - first) * sizeof(T));
+        count_ += count;
+        return count;
+    }
+
+    std::size_t pop(T* items, std::size_t count) noexcept
+    {
+        if (count > count_)
+            count = count_;
+
+        const std::size_t first = count < capacity_ - head_ ? count : capacity_ - head_;
+        std::memcpy(items, buffer_ + head_, first * sizeof(T));
+        std::memcpy(items + first, buffer_, (count - first) * sizeof(T));
+        head_ = (head_ + count) % capacity_;
+        count_ -= count;
+        return count;
+    }
+
+    // moves items between the buffer and suspended coroutines until neither side can make progress,
+    // and returns the coroutines that are done
+    waiter* pump() noexcept
+    {
+        waiter* ready = nullptr;
+        bool moved = true;
+        while (moved)
+        {
+            moved = false;
+            while (receivers_.head && count_ > 0)
+            {
+                waiter* receiver = receivers_.pop();
+                receiver->done = pop(receiver->out, receiver->count);
+                ready = chain(ready, receiver);
+                moved = true;
+            }
+
+            while (senders_.head && count_ < capacity_)
+            {
+                waiter* sender = senders_.head;
+                sender->done += push(sender->in + sender->done, sender->count - sender->done);
+                if (sender->done == sender->count)
+                    ready = chain(ready, senders_.pop());
+                moved = true;
+            }
+        }
+        return ready;
+    }
+
+    void wake(waiter* ready)
+    {
+        while (ready)
+        {
+            // the coroutine can finish and free the waiter as soon as it is posted
+            waiter* next = ready->next;
+            executor_.post(detail::resume, ready->handle.address());
+            ready = next;
+        }
+    }
+
+    bool suspend_sender(waiter& sender)
+    {
+        waiter* ready = nullptr;
+        bool suspended = false;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (closed_)
+                return false;
+
+            // earlier senders still waiting go first, so batches aren't interleaved
+            if (!senders_.head)
+                sender.done = push(sender.in, sender.count);
+            if (sender.done < sender.count)
+            {
+                senders_.push(&sender);
+                suspended = true;
+            }
+            ready = pump();
+        }
+        wake(ready);
+        return suspended;
+    }
+
+    bool suspend_receiver(waiter& receiver)
+    {
+        waiter* ready = nullptr;
+        bool suspended = false;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            receiver.done = pop(receiver.out, receiver.count);
+            if (receiver.done == 0 && !closed_)
+            {
+                receivers_.push(&receiver);
+                suspended = true;
+            }
+            ready = pump();
+        }
+        wake(ready);
+        return suspended;
+    }
+
+    Executor& executor_;
+    T* buffer_;
+    std::size_t capacity_;
+    std::size_t head_;
+    std::size_t count_;
+    bool closed_;
+    std::mutex mutex_;
+    waiter_queue senders_;
+    waiter_queue receivers_;
+};
+#endif
+
+}
+
+#ifdef DYNAMIC_LIST_SPAN
+template <class T>
+inline constexpr bool std::ranges::enable_borrowed_range<dynamic_list::list_view<T>> = true;
+#endif
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+// helpers shared by the test and benchmark programs. none of this is part of the library.
+
+typedef struct
+{
+    unsigned long long state;
+} Random;
+
+// splitmix64, so every run with the same seed sees the same values
+static inline unsigned long long random_next(Random* random)
+{
+    unsigned long long z = (random->state += 0x9E3779B97F4A7C15ull);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+static inline size_t random_below(Random* random, const size_t bound)
+{
+    return (size_t)(random_next(random) % bound);
+}
+
+// bump allocator over 64MB chunks; free does nothing and realloc always copies. every block keeps
+// its size in a max_align_t header in front of it, which realloc needs to know how much to copy
+#define ARENA_CHUNK ((size_t)64 << 20)
+#define ARENA_HEADER sizeof(max_align_t)
+
+typedef struct
+{
+    unsigned char* chunk;
+    size_t used;
+    size_t size;
+} Arena;
+
+static inline size_t arena_block_size(const void* ptr)
+{
+    size_t size;
+    memcpy(&size, (const unsigned char*)ptr - ARENA_HEADER, sizeof(size));
+    return size;
+}
+
+static inline void* arena_alloc(const size_t size, void* context)
+{
+    Arena* arena = context;
+    const size_t needed = ARENA_HEADER + (size + ARENA_HEADER - 1) / ARENA_HEADER * ARENA_HEADER;
+
+    // chunks are chained through their first bytes so the whole arena is released in one pass
+    if (!arena->chunk || arena->size - arena->used < needed)
+    {
+        const size_t chunk_size = ARENA_HEADER + (needed > ARENA_CHUNK ? needed : ARENA_CHUNK);
+        unsigned char* chunk = malloc(chunk_size);
+        if (!chunk)
+            return NULL;
+
+        memcpy(chunk, &arena->chunk, sizeof(arena->chunk));
+        arena->chunk = chunk;
+        arena->used = ARENA_HEADER;
+        arena->size = chunk_size;
+    }
+
+    unsigned char* block = arena->chunk + arena->used + ARENA_HEADER;
+    memcpy(block - ARENA_HEADER, &size, sizeof(size));
+    arena->used += needed;
+    return block;
+}
+
+static inline void* arena_realloc(void* ptr, const size_t size, void* context)
+{
+    const size_t old_size = arena_block_size(ptr);
+    void* block = arena_alloc(size, context);
+    if (block)
+        memcpy(block, ptr, old_size < size ? old_size : size);
+    return block;
+}
+
+static inline void arena_free(void* ptr, void* context)
+{
+    (void)ptr;
+    (void)context;
+}
+
+static inline void arena_release(Arena* arena)
+{
+    while (arena->chunk)
+    {
+        unsigned char* next;
+        memcpy(&next, arena->chunk, sizeof(next));
+        free(arena->chunk);
+        arena->chunk = next;
+    }
+}
@@ -0,0 +1,821 @@
+#define DYNAMIC_LIST_ACCOUNTING
+#define DYNAMIC_LIST_DIRTY_TRACKING
+#define DYNAMIC_LIST_DIRTY_BLOCK 64
+#define DYNAMIC_LIST_IMPL
+#include "dynamic_list.h"
+#include "support.h"
+
+#include <fcntl.h>
+#include <limits.h>
+#include <unistd.h>
+
+// checks each feature against simple reference results, and feeds the ones that read untrusted input
+// malformed input. meant to be built with sanitizers, which catch the out of bounds accesses a bad
+// length would cause:
+//
+//     $ gcc tests.c -std=c11 -g -fsanitize=address,undefined -o tests -lm
+//     $ ./tests
+//
+// and again with -DDYNAMIC_LIST_NO_THREADS, so the external sort is checked without its io thread.
+//
+// every failed check is printed, and the exit status is the number of failures.
+
+static int failures;
+
+#define CHECK(condition) do { \
+    if (!(condition)) \
+    { \
+        fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+        failures++; \
+    } \
+} while (0)
+
+typedef struct
+{
+    unsigned key;
+    unsigned index;
+} Keyed;
+
+static int compare_keys(const void* a, const void* b)
+{
+    const unsigned x = ((const Keyed*)a)->key;
+    const unsigned y = ((const Keyed*)b)->key;
+    return (x > y) - (x < y);
+}
+
+static int collect_keyed(const void* items, const size_t count, void* context)
+{
+    Keyed** sorted = context;
+    const size_t length = list_len(*sorted);
+    list_resize(*sorted, count);
+    memcpy(*sorted + length, items, count * sizeof(Keyed));
+    return 0;
+}
+
+static int reject_keyed(const void* items, const size_t count, void* context)
+{
+    (void)items;
+    (void)count;
+    (void)context;
+    return -1;
+}
+
+// whether `sorted` holds every index below `count` once, with keys in order and equal keys in input order
+static int sorted_stably(const Keyed* sorted, const size_t count)
+{
+    if (list_len(sorted) != count)
+        return 0;
+
+    unsigned char* seen = calloc(count ? count : 1, 1);
+    int ok = seen != NULL;
+    for (size_t i = 0; ok && i < count; i++)
+    {
+        ok = sorted[i].index < count && !seen[sorted[i].index];
+        if (ok)
+            seen[sorted[i].index] = 1;
+        if (ok && i > 0)
+        {
+            ok = sorted[i - 1].key < sorted[i].key
+                || (sorted[i - 1].key == sorted[i].key && sorted[i - 1].index < sorted[i].index);
+        }
+    }
+    free(seen);
+    return ok;
+}
+
+static FILE* keyed_input(Random* random, const size_t count, const unsigned keys)
+{
+    FILE* in = tmpfile();
+    for (size_t i = 0; in && i < count; i++)
+    {
+        const Keyed item = {(unsigned)random_below(random, keys), (unsigned)i};
+        fwrite(&item, sizeof(item), 1, in);
+    }
+    if (in)
+        rewind(in);
+    return in;
+}
+
+static int external_sorts(Random* random, const size_t count, const size_t run_capacity)
+{
+    FILE* in = keyed_input(random, count, 50);
+    if (!in)
+        return 0;
+
+    Keyed* sorted = list_new(Keyed);
+    const int ok = list_external_sort_stream(in, sizeof(Keyed), run_capacity, compare_keys, collect_keyed, &sorted,
+        NULL) == 0 && sorted_stably(sorted, count);
+    list_free(sorted);
+    fclose(in);
+    return ok;
+}
+
+static void test_external_sort(void)
+{
+    Random random = {4};
+    const size_t live_lists = list_allocator_stats(NULL).live_lists;
+
+    // nothing, a single run sorted in memory, and a single full run that goes through a file
+    CHECK(external_sorts(&random, 0, 16));
+    CHECK(external_sorts(&random, 10, 16));
+    CHECK(external_sorts(&random, 16, 16));
+    CHECK(external_sorts(&random, 17, 16));
+
+    // enough runs that groups are merged while reading, and more are left over than one merge takes
+    const size_t runs = DYNAMIC_LIST_MERGE_FANIN * 2 + DYNAMIC_LIST_MERGE_FANIN - 1;
+    CHECK(external_sorts(&random, runs * 4 - 1, 4));
+    CHECK(external_sorts(&random, runs * 4 + 1, 4));
+
+    // more runs than a process may have files open
+    CHECK(external_sorts(&random, 200000, 3));
+
+    // into a file
+    FILE* in = keyed_input(&random, 1000, 1000);
+    FILE* out = tmpfile();
+    CHECK(in && out && list_external_sort(in, out, sizeof(Keyed), 7, compare_keys, NULL) == 0);
+    if (in && out)
+    {
+        Keyed* sorted = list_new(Keyed);
+        rewind(out);
+        list_resize(sorted, 1000);
+        const size_t read = fread(sorted, sizeof(Keyed), 1000, out);
+        CHECK(read == 1000 && fgetc(out) == EOF && sorted_stably(sorted, 1000));
+        list_free(sorted);
+    }
+
+    // a failing sink fails the sort, whether it gets one run or a merge
+    rewind(in);
+    CHECK(list_external_sort_stream(in, sizeof(Keyed), 2000, compare_keys, reject_keyed, NULL, NULL) == -1);
+    rewind(in);
+    CHECK(list_external_sort_stream(in, sizeof(Keyed), 7, compare_keys, reject_keyed, NULL, NULL) == -1);
+    if (in)
+        fclose(in);
+    if (out)
+        fclose(out);
+
+    CHECK(list_allocator_stats(NULL).live_lists == live_lists);
+}
+
+// applies the checkpoint in `path` to `copy`, returning how many blocks it carried or -1 if it is malformed
+static long apply_checkpoint(const char* path, unsigned char** copy)
+{
+    FILE* file = fopen(path, "rb");
+    if (!file)
+        return -1;
+
+    long blocks = -1;
+    unsigned long long header[4];
+    if (fread(header, sizeof(header), 1, file) == 1 && header[0] == 0x314B43504C44ull)
+    {
+        // the copy takes the new length first, the records then fill in what changed
+        const size_t used = header[1] * header[2];
+        while (list_len(*copy) > used)
+            list_pop_back(*copy);
+        if (list_len(*copy) < used)
+            list_resize(*copy, used - list_len(*copy));
+
+        unsigned long long record[2];
+        for (blocks = 0; fread(record, sizeof(record), 1, file) == 1 && record[0] != ~0ull; blocks++)
+        {
+            const unsigned long long offset = record[0] * header[3];
+            if (offset + record[1] > used || fread(*copy + offset, 1, record[1], file) != record[1])
+                break;
+        }
+        if (record[0] != ~0ull || record[1] != 0)
+            blocks = -1;
+    }
+
+    fclose(file);
+    return blocks;
+}
+
+static long checkpoint(void* list, unsigned char** copy)
+{
+    const char* path = "tests.ckpt";
+    const int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0600);
+    if (fd < 0)
+        return -1;
+
+    const int written = list_checkpoint_delta(list, fd);
+    close(fd);
+    const long blocks = written == 0 ? apply_checkpoint(path, copy) : -1;
+    remove(path);
+    return blocks;
+}
+
+static int same_bytes(const void* list, const unsigned char* copy)
+{
+    const size_t used = list_len(list) * list_prelude(list)->stride;
+    return list_len(copy) == used && (used == 0 || memcmp(list, copy, used) == 0);
+}
+
+typedef struct
+{
+    unsigned char bytes[100];
+} Wide;
+
+static void test_dirty_tracking(void)
+{
+    int* list = list_new(int);
+    unsigned char* copy = list_new(unsigned char);
+    CHECK(list_checkpoint_delta(list, -1) == -1);
+
+    for (int i = 0; i < 100; i++)
+        list_append(list, i);
+    CHECK(list_track_dirty(list) == 0);
+
+    // the first checkpoint carries every block, the next one none
+    CHECK(checkpoint(list, &copy) == 7 && same_bytes(list, copy));
+    CHECK(checkpoint(list, &copy) == 0 && same_bytes(list, copy));
+
+    // writes to one block make one record, a write across a block edge marks both blocks
+    list_set(list, 3, 42);
+    list_set(list, 5, 7);
+    CHECK(checkpoint(list, &copy) == 1 && same_bytes(list, copy));
+    list[40] = -1;
+    list_mark_dirty(list, 40, 1);
+    list_mark_dirty(list, 15, 2);
+    CHECK(checkpoint(list, &copy) == 3 && same_bytes(list, copy));
+
+    // growing keeps the bits already set, here block 0, and marks the new items from block 6 to 68
+    list_set(list, 0, 1);
+    for (int i = 0; i < 1000; i++)
+        list_append(list, i * 3);
+    CHECK(checkpoint(list, &copy) == 64 && same_bytes(list, copy));
+
+    // shrinking is carried by the length
+    list_remove_at(list, 10);
+    CHECK(checkpoint(list, &copy) == 1 && same_bytes(list, copy));
+    list_pop_back(list);
+    CHECK(checkpoint(list, &copy) == 0 && same_bytes(list, copy));
+    list_clear(list);
+    CHECK(checkpoint(list, &copy) == 0 && list_len(copy) == 0);
+    list_free(list);
+
+    // items wider than a block, tracked from empty
+    Wide* wide = list_new(Wide);
+    CHECK(list_track_dirty(wide) == 0);
+    for (int i = 0; i < 50; i++)
+    {
+        Wide item;
+        memset(item.bytes, i, sizeof(item.bytes));
+        list_append(wide, item);
+    }
+    CHECK(checkpoint(wide, &copy) == 79 && same_bytes(wide, copy));
+    list_free(wide);
+    list_free(copy);
+}
+
+static unsigned char* random_bytes(Random* random, const size_t length, const unsigned alphabet)
+{
+    unsigned char* list = create_list(1, length ? length : 1, NULL);
+    list_resize(list, length);
+    for (size_t i = 0; i < length; i++)
+        list[i] = (unsigned char)random_below(random, alphabet);
+    return list;
+}
+
+static int patch_matches(const void* a, const void* b, const size_t block_size)
+{
+    unsigned char* script = create_list_diff(a, b, block_size, NULL);
+    unsigned char* rebuilt = script ? list_patch(a, script) : NULL;
+    const int matches = rebuilt && list_equal(rebuilt, b);
+    if (rebuilt)
+        list_free(rebuilt);
+    if (script)
+        list_free(script);
+    return matches;
+}
+
+static unsigned char* patch_script(const unsigned long long length, const unsigned char op,
+    const unsigned long long first, const unsigned long long count)
+{
+    const ListDiffHeader header = {LIST_DIFF_MAGIC, sizeof(int), length, 4};
+    unsigned char* script = list_new(unsigned char);
+    script = list_put_bytes(script, &header, sizeof(header));
+    script = list_put_op(script, op, first, count);
+    return list_put_op(script, 'E', 0, 0);
+}
+
+static int patch_rejects(const void* a, unsigned char* script)
+{
+    void* result = list_patch(a, script);
+    list_free(script);
+    if (!result)
+        return 1;
+    list_free(result);
+    return 0;
+}
+
+static void test_diff_patch(void)
+{
+    Random random = {1};
+    for (int round = 0; round < 200; round++)
+    {
+        const unsigned alphabet = 1 + (unsigned)random_below(&random, 4);
+        unsigned char* a = random_bytes(&random, random_below(&random, 4096), alphabet);
+        unsigned char* b = random_bytes(&random, random_below(&random, 4096), alphabet);
+
+        // mostly copies of a, shifted, with some new bytes mixed in
+        for (size_t i = 0; i < list_len(b) && list_len(a) > 0; i++)
+        {
+            if (random_below(&random, 8))
+                b[i] = a[(i + (size_t)round) % list_len(a)];
+        }
+
+        CHECK(patch_matches(a, b, 1 + random_below(&random, 64)));
+        CHECK(patch_matches(a, a, 16));
+        list_free(a);
+        list_free(b);
+    }
+
+    // a source that repeats one block used to make the block table quadratic
+    unsigned char* zeros = create_list(1, 1 << 20, NULL);
+    list_resize(zeros, 1 << 20);
+    memset(zeros, 0, 1 << 20);
+    unsigned char* script = create_list_diff(zeros, zeros, 64, NULL);
+    CHECK(script && list_len(script) < 256);
+    unsigned char* rebuilt = list_patch(zeros, script);
+    CHECK(rebuilt && list_equal(rebuilt, zeros));
+    list_free(rebuilt);
+    list_free(script);
+    list_free(zeros);
+
+    int* a = list_new(int);
+    for (int i = 0; i < 64; i++)
+        list_append(a, i);
+
+    script = patch_script(64, 'C', 0, 16);
+    rebuilt = list_patch(a, script);
+    CHECK(rebuilt && list_equal(rebuilt, a));
+    list_free(rebuilt);
+    list_free(script);
+
+    // ranges and lengths that wrap, lengths the script can't supply, and broken framing
+    CHECK(patch_rejects(a, patch_script(4, 'C', ~0ull, 1)));
+    CHECK(patch_rejects(a, patch_script(4, 'C', 2, ~0ull)));
+    CHECK(patch_rejects(a, patch_script(4, 'C', 15, 2)));
+    CHECK(patch_rejects(a, patch_script(0x4000000000000001ull, 'L', 0x4000000000000001ull, 0)));
+    CHECK(patch_rejects(a, patch_script(4, 'L', 0x4000000000000001ull, 0)));
+    CHECK(patch_rejects(a, patch_script(1ull << 40, 'C', 0, 16)));
+    CHECK(patch_rejects(a, patch_script(64, 'X', 0, 16)));
+    CHECK(patch_rejects(a, patch_script(65, 'C', 0, 16)));
+
+    script = patch_script(64, 'C', 0, 16);
+    list_len(script) -= 20;
+    CHECK(patch_rejects(a, script));
+
+    script = patch_script(64, 'C', 0, 16);
+    script[0] ^= 1;
+    CHECK(patch_rejects(a, script));
+
+    long long* wide = list_new(long long);
+    script = list_diff(a, a);
+    CHECK(list_patch(wide, script) == NULL);
+    list_free(script);
+    list_free(wide);
+    list_free(a);
+}
+
+static void test_hash(void)
+{
+    Random random = {3};
+    const size_t lengths[] = {0, 1, 63, 64, 65, 1000, 1024, 4096, 100003};
+    for (size_t i = 0; i < sizeof(lengths) / sizeof(lengths[0]); i++)
+    {
+        unsigned char* list = random_bytes(&random, lengths[i], 256);
+        const unsigned long long expected = list_hash64(list);
+
+        // the same bytes in pieces of every size
+        ListHashState state;
+        list_hash_init(&state, 0);
+        for (size_t offset = 0; offset < lengths[i];)
+        {
+            size_t piece = 1 + random_below(&random, 200);
+            if (piece > lengths[i] - offset)
+                piece = lengths[i] - offset;
+            list_hash_update(&state, list + offset, piece);
+            offset += piece;
+        }
+        CHECK(list_hash_digest(&state) == expected);
+
+        // and synced after every few appends
+        unsigned char* grown = list_new(unsigned char);
+        list_hash_init(&state, 0);
+        for (size_t j = 0; j < lengths[i]; j++)
+        {
+            list_append(grown, list[j]);
+            if (random_below(&random, 50) == 0)
+                CHECK(list_hash_sync(&state, grown) == 0);
+        }
+        CHECK(list_hash_sync(&state, grown) == 0);
+        CHECK(list_hash_digest(&state) == expected);
+
+        if (lengths[i] > 0)
+        {
+            list_len(grown) -= 1;
+            CHECK(list_hash_sync(&state, grown) == -1);
+        }
+        list_free(grown);
+        list_free(list);
+    }
+}
+
+// exports a list and releases the array the way a consumer would, without taking it back
+static int arrow_released(void* list, const char* format)
+{
+    struct ArrowArray array;
+    struct ArrowSchema schema;
+    if (list_to_arrow_array(list, format, &array, &schema) != 0)
+        return 0;
+
+    const int exported = array.length == (int64_t)list_len(list) && array.buffers[1] == list;
+    array.release(&array);
+    schema.release(&schema);
+    return exported && array.release == NULL && schema.release == NULL;
+}
+
+static void test_arrow(void)
+{
+    struct ArrowArray array;
+    struct ArrowSchema schema;
+
+    int* list = list_new(int);
+    for (int i = 0; i < 100; i++)
+        list_append(list, i);
+    CHECK(list_to_arrow_array(list, "l", &array, &schema) == -1);
+
+    // an exported list comes back as itself, and any other array is copied
+    CHECK(list_to_arrow_array(list, "i", &array, &schema) == 0);
+    CHECK(list_from_arrow_array(&array, &schema, NULL) == list);
+    schema.release(&schema);
+
+    int* copy = list_new(int);
+    for (int i = 0; i < 100; i++)
+        list_append(copy, i);
+    CHECK(list_to_arrow_array(copy, "i", &array, &schema) == 0);
+    array.offset = 10;
+    array.length = 90;
+    int* sliced = list_from_arrow_array(&array, &schema, NULL);
+    CHECK(sliced && list_len(sliced) == 90 && sliced[0] == 10 && array.release == NULL);
+    schema.release(&schema);
+    list_free(sliced);
+
+    CHECK(arrow_released(list, "i"));
+
+    // the last list of a batch and a mapped list both take their allocator with them when freed
+    int* lists[2];
+    CHECK(list_new_batch(int, lists, 2, 4, NULL) == 0);
+    list_free(lists[0]);
+    CHECK(arrow_released(lists[1], "i"));
+
+    if (list_host_is_little_endian())
+    {
+        const char* path = "tests.npy";
+        long long* saved = list_new(long long);
+        for (long long i = 0; i < 100; i++)
+            list_append(saved, i);
+        CHECK(list_save_npy(saved, path, "<i8") == 0);
+        long long* mapped = list_map_npy(long long, path, "<i8");
+        CHECK(mapped && arrow_released(mapped, "l"));
+        remove(path);
+        list_free(saved);
+    }
+}
+
+static void write_npy(const char* path, const char* shape, const size_t data_bytes)
+{
+    char header[128];
+    int size = snprintf(header, sizeof(header), "{'descr': '<i8', 'fortran_order': False, 'shape': %s, }", shape);
+    while ((10 + size + 1) % 64 != 0)
+        header[size++] = ' ';
+    header[size++] = '\n';
+
+    FILE* file = fopen(path, "wb");
+    if (!file)
+        return;
+    fwrite("\x93NUMPY\x01\x00", 1, 8, file);
+    fputc(size & 0xFF, file);
+    fputc(size >> 8, file);
+    fwrite(header, 1, (size_t)size, file);
+    for (size_t i = 0; i < data_bytes; i++)
+        fputc((int)i, file);
+    fclose(file);
+}
+
+static int npy_rejects(const char* path)
+{
+    long long* loaded = list_load_npy(long long, path, "<i8");
+    long long* mapped = list_map_npy(long long, path, "<i8");
+    const int rejected = !loaded && !mapped;
+    if (loaded)
+        list_free(loaded);
+    if (mapped)
+        list_free(mapped);
+    return rejected;
+}
+
+static void test_npy(void)
+{
+    if (!list_host_is_little_endian())
+        return;
+
+    const char* path = "tests.npy";
+    long long* list = list_new(long long);
+    for (long long i = 0; i < 1000; i++)
+        list_append(list, i * i - 500);
+
+    CHECK(list_save_npy(list, path, "<i8") == 0);
+    CHECK(list_save_npy(list, path, "<i4") == -1);
+
+    long long* loaded = list_load_npy(long long, path, "<i8");
+    CHECK(loaded && list_equal(loaded, list));
+    long long* mapped = list_map_npy(long long, path, "<i8");
+    CHECK(mapped && list_equal(mapped, list));
+    CHECK(list_load_npy(long long, path, "<u8") == NULL);
+
+    // appending moves a mapped list onto the heap
+    const long long extra = 7;
+    list_append(mapped, extra);
+    CHECK(list_len(mapped) == 1001 && mapped[999] == list[999] && mapped[1000] == extra);
+    list_free(mapped);
+    list_free(loaded);
+
+    // an empty array maps to a list with no capacity, which has to be able to grow
+    long long* empty = list_new(long long);
+    CHECK(list_save_npy(empty, path, "<i8") == 0);
+    list_free(empty);
+    empty = list_map_npy(long long, path, "<i8");
+    CHECK(empty && list_len(empty) == 0);
+    for (long long i = 0; i < 100; i++)
+        list_append(empty, i);
+    CHECK(list_len(empty) == 100 && empty[99] == 99);
+    list_free(empty);
+
+    write_npy(path, "(2, 2)", 32);
+    loaded = list_load_npy(long long, path, "<i8");
+    CHECK(loaded && list_len(loaded) == 4);
+    list_free(loaded);
+
+    // a truncated file, and a shape whose product wraps around to fit the file
+    write_npy(path, "(4,)", 24);
+    CHECK(npy_rejects(path));
+    write_npy(path, "(3, 6148914691236517206)", 16);
+    CHECK(npy_rejects(path));
+
+    remove(path);
+    list_free(list);
+}
+
+static void test_parse(void)
+{
+    size_t consumed = 0;
+
+    long long* ints = list_new(long long);
+    const char* text = " 1, -2,,\n9223372036854775807,-9223372036854775808\n";
+    ints = list_parse_ints_into(ints, sizeof(long long), text, strlen(text), ',', &consumed);
+    CHECK(list_len(ints) == 4 && consumed == strlen(text));
+    CHECK(ints[0] == 1 && ints[1] == -2 && ints[2] == LLONG_MAX && ints[3] == LLONG_MIN);
+
+    list_clear(ints);
+    text = "5,9223372036854775808,6";
+    ints = list_parse_ints_into(ints, sizeof(long long), text, strlen(text), ',', &consumed);
+    CHECK(list_len(ints) == 1 && consumed == 2);
+
+    // past 64 bits, in the eight digit step and in the digit loop
+    list_clear(ints);
+    text = "1844674407370955161712345678,1";
+    ints = list_parse_ints_into(ints, sizeof(long long), text, strlen(text), ',', &consumed);
+    CHECK(list_len(ints) == 0 && consumed == 0);
+    list_clear(ints);
+    text = "18446744073709551616";
+    ints = list_parse_ints_into(ints, sizeof(long long), text, strlen(text), ',', &consumed);
+    CHECK(list_len(ints) == 0);
+    list_free(ints);
+
+    signed char* bytes = list_new(signed char);
+    text = "127,-128,128";
+    bytes = list_parse_ints_into(bytes, sizeof(signed char), text, strlen(text), ',', &consumed);
+    CHECK(list_len(bytes) == 2 && bytes[0] == 127 && bytes[1] == -128 && consumed == 9);
+    list_free(bytes);
+
+    // the fraction's digits are added onto the integer part's, which must not wrap
+    double* doubles = list_new(double);
+    text = "184467440737.09551617,0.1,-2.5e-3,1e22,1e23";
+    doubles = list_parse_floats_into(doubles, sizeof(double), text, strlen(text), ',', &consumed);
+    CHECK(list_len(doubles) == 5);
+    CHECK(doubles[0] == strtod("184467440737.09551617", NULL) && doubles[1] == 0.1);
+    CHECK(doubles[2] == -2.5e-3 && doubles[3] == 1e22 && doubles[4] == 1e23);
+
+    list_clear(doubles);
+    text = "1,1e400,2";
+    doubles = list_parse_floats_into(doubles, sizeof(double), text, strlen(text), ',', &consumed);
+    CHECK(list_len(doubles) == 1 && consumed == 2);
+    list_free(doubles);
+
+    float* floats = list_new(float);
+    text = "0.1,3.4e38,3.5e39";
+    floats = list_parse_floats_into(floats, sizeof(float), text, strlen(text), ',', &consumed);
+    CHECK(list_len(floats) == 2 && floats[0] == 0.1f && floats[1] == 3.4e38f && consumed == 11);
+
+    // floats are rounded once, to the same value strtof gives
+    Random random = {2};
+    char number[64];
+    int mismatches = 0;
+    for (int i = 0; i < 100000; i++)
+    {
+        const int size = i % 2
+            ? snprintf(number, sizeof(number), "%ue%d", (unsigned)random_below(&random, 1u << 24),
+                (int)random_below(&random, 21) - 10)
+            : snprintf(number, sizeof(number), "%u.%05u", (unsigned)random_below(&random, 100000),
+                (unsigned)random_below(&random, 100000));
+        list_clear(floats);
+        floats = list_parse_floats_into(floats, sizeof(float), number, (size_t)size, ',', NULL);
+        mismatches += list_len(floats) != 1 || floats[0] != strtof(number, NULL);
+    }
+    CHECK(mismatches == 0);
+    list_free(floats);
+}
+
+static void test_wire(void)
+{
+    int* list = list_new(int);
+    for (int i = 0; i < 50000; i++)
+        list_append(list, i * 7919 - 12345);
+
+    for (int flags = 0; flags <= LIST_WIRE_CHECKSUMS; flags++)
+    {
+        unsigned char* bytes = list_wire_encode(list, LIST_WIRE_INT, flags, NULL);
+        CHECK(bytes != NULL);
+        int* decoded = list_wire_decode(int, bytes, list_len(bytes));
+        CHECK(decoded && list_equal(decoded, list));
+        list_free(decoded);
+
+        CHECK(list_wire_decode(short, bytes, list_len(bytes)) == NULL);
+        CHECK(list_wire_decode(int, bytes, LIST_WIRE_HEADER_SIZE - 1) == NULL);
+        CHECK(list_wire_decode(int, bytes, list_len(bytes) - 1) == NULL);
+
+        if (flags & LIST_WIRE_CHECKSUMS)
+        {
+            bytes[LIST_WIRE_HEADER_SIZE + 100] ^= 1;
+            CHECK(list_wire_decode(int, bytes, list_len(bytes)) == NULL);
+        }
+        list_free(bytes);
+    }
+
+    unsigned int swapped[] = {0x01020304u, 0xA0B0C0D0u};
+    list_byte_swap(swapped, 2, sizeof(unsigned int));
+    CHECK(swapped[0] == 0x04030201u && swapped[1] == 0xD0C0B0A0u);
+    list_free(list);
+}
+
+// an allocator that can be told to fail, to check a list survives a grow that can't allocate
+typedef struct
+{
+    int fail;
+} Failing;
+
+static void* failing_alloc(const size_t size, void* context)
+{
+    return ((Failing*)context)->fail ? NULL : malloc(size);
+}
+
+static void* failing_realloc(void* ptr, const size_t size, void* context)
+{
+    return ((Failing*)context)->fail ? NULL : realloc(ptr, size);
+}
+
+static void failing_free(void* ptr, void* context)
+{
+    (void)context;
+    free(ptr);
+}
+
+static void relocate_longs(void* to, void* from, const size_t count)
+{
+    memcpy(to, from, count * sizeof(long));
+}
+
+static void test_grow_failure(void)
+{
+    Failing failing = {0};
+    Allocator allocator = {
+        .alloc = failing_alloc,
+        .realloc = failing_realloc,
+        .free = failing_free,
+        .context = &failing,
+    };
+
+    long* list = create_list(sizeof(long), 2, &allocator);
+    for (long i = 0; i < 2; i++)
+        list_append(list, i);
+
+    failing.fail = 1;
+    CHECK(list_ensure_capacity(list, 1, sizeof(long)) == NULL);
+    CHECK(list_ensure_capacity_relocate(list, 1, sizeof(long), relocate_longs) == NULL);
+    CHECK(list_len(list) == 2 && list_cap(list) == 2 && list[1] == 1);
+    CHECK(list_allocator_stats(&allocator).live_lists == 1);
+
+    failing.fail = 0;
+    for (long i = 2; i < 100; i++)
+        list_append(list, i);
+    CHECK(list_len(list) == 100 && list[99] == 99);
+    list_free(list);
+    CHECK(list_allocator_stats(&allocator).live_lists == 0 && list_allocator_stats(&allocator).live_bytes == 0);
+}
+
+typedef struct
+{
+    long key;
+    long value;
+    void* next;
+} Node;
+
+static void test_pool(void)
+{
+    const size_t live_lists = list_allocator_stats(NULL).live_lists;
+    ListPool pool;
+    CHECK(list_pool_init(&pool, Node, NULL) == 0);
+
+    // a freed slot is poisoned, which clearing used to trip over
+    Node* first = list_pool_alloc(&pool);
+    Node* second = list_pool_alloc(&pool);
+    list_pool_free(&pool, first);
+    CHECK(list_pool_alloc(&pool) == first);
+    list_pool_free(&pool, second);
+    list_pool_clear(&pool);
+    CHECK(pool.live == 0);
+
+    Node* nodes[5000];
+    for (int round = 0; round < 3; round++)
+    {
+        for (size_t i = 0; i < 5000; i++)
+        {
+            nodes[i] = list_pool_alloc(&pool);
+            CHECK(nodes[i] != NULL && (uintptr_t)nodes[i] % _Alignof(Node) == 0);
+            nodes[i]->key = (long)i;
+        }
+        for (size_t i = 0; i < 5000; i += 3)
+            list_pool_free(&pool, nodes[i]);
+        for (size_t i = 1; i < 5000; i += 3)
+            CHECK(nodes[i]->key == (long)i);
+        CHECK(pool.live == 5000 - 1667);
+        list_pool_clear(&pool);
+    }
+
+    list_pool_destroy(&pool);
+    CHECK(list_allocator_stats(NULL).live_lists == live_lists);
+}
+
+static void test_batch(void)
+{
+    const ListAllocatorStats before = list_allocator_stats(NULL);
+    int* lists[64];
+    CHECK(list_new_batch(int, lists, 64, 4, NULL) == 0);
+    CHECK(list_allocator_stats(NULL).live_lists == before.live_lists + 64);
+
+    // some lists stay in their slots, the others grow out of them
+    for (int i = 0; i < 64; i++)
+    {
+        for (int j = 0; j < (i % 2 ? 100 : 4); j++)
+            list_append(lists[i], j);
+    }
+    for (int i = 0; i < 64; i++)
+        CHECK(list_len(lists[i]) == (i % 2 ? 100u : 4u) && lists[i][3] == 3);
+
+    for (int i = 63; i >= 0; i -= 2)
+        list_free(lists[i]);
+    for (int i = 0; i < 64; i += 2)
+        list_free(lists[i]);
+    const ListAllocatorStats after = list_allocator_stats(NULL);
+    CHECK(after.live_lists == before.live_lists && after.live_bytes == before.live_bytes);
+
+    char* names[3];
+    CHECK(create_lists_batch(3, 3, 0, NULL, names) == 0);
+    for (int i = 0; i < 3; i++)
+        list_free(names[i]);
+    CHECK(create_lists_batch(0, 3, 0, NULL, names) == 0);
+
+    // sizes whose product wraps
+    CHECK(create_lists_batch(SIZE_MAX / 8, 3, 4, NULL, names) == -1);
+    CHECK(create_lists_batch(3, SIZE_MAX / 2, 4, NULL, names) == -1);
+}
+
+int main(void)
+{
+    test_external_sort();
+    test_dirty_tracking();
+    test_diff_patch();
+    test_hash();
+    test_arrow();
+    test_npy();
+    test_parse();
+    test_wire();
+    test_grow_failure();
+    test_pool();
+    test_batch();
+
+    if (failures == 0)
+        printf("all tests passed\n");
+    return failures;
+}
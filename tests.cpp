@@ -0,0 +1,474 @@
+#include "dynamic_list.hpp"
+
+#include <cstdio>
+#include <numeric>
+#include <random>
+#include <string>
+
+// checks the C++ adapters in dynamic_list.hpp. the implementation is compiled as C from tests_impl.c,
+// with accounting so the adapters can be checked for lists they leak:
+//
+//     $ gcc tests_impl.c -c -std=c11 -g -fsanitize=address,undefined -o tests_impl.o
+//     $ g++ tests.cpp tests_impl.o -std=c++20 -g -fsanitize=address,undefined -o tests_cpp -lm
+//     $ ./tests_cpp
+//
+// every failed check is printed, and the exit status is the number of failures.
+
+static int failures;
+
+#define CHECK(condition) do { \
+    if (!(condition)) \
+    { \
+        std::fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+        failures++; \
+    } \
+} while (0)
+
+static void test_pmr()
+{
+    const std::size_t live_lists = list_allocator_stats(nullptr).live_lists;
+
+    std::pmr::monotonic_buffer_resource arena;
+    dynamic_list::resource_allocator allocator(&arena);
+    int* list = list_new_alloc(int, allocator.get());
+    for (int i = 0; i < 1000; i++)
+        list_append(list, i);
+    CHECK(list_len(list) == 1000 && list[999] == 999);
+    CHECK(list_allocator_stats(allocator.get()).live_lists == 1);
+    list_free(list);
+    CHECK(list_allocator_stats(allocator.get()).live_lists == 0);
+
+    // a resource that throws makes the list fail to allocate
+    dynamic_list::resource_allocator empty(std::pmr::null_memory_resource());
+    CHECK(list_new_alloc(int, empty.get()) == nullptr);
+
+    // containers over an Allocator, including one that is itself over a resource
+    dynamic_list::allocator_resource resource(allocator.get());
+    std::pmr::vector<int> values(&resource);
+    for (int i = 0; i < 1000; i++)
+        values.push_back(i);
+    CHECK(values.size() == 1000 && values[999] == 999);
+
+    struct alignas(64) Wide
+    {
+        char bytes[64];
+    };
+    std::pmr::vector<Wide> wide(&resource);
+    wide.resize(10);
+    CHECK(reinterpret_cast<std::uintptr_t>(wide.data()) % 64 == 0);
+
+    dynamic_list::allocator_resource plain;
+    std::pmr::vector<double> doubles(&plain);
+    doubles.resize(100);
+    CHECK(resource.is_equal(resource) && !resource.is_equal(plain));
+    CHECK(dynamic_list::allocator_resource(allocator.get()).is_equal(resource));
+
+    CHECK(list_allocator_stats(nullptr).live_lists == live_lists);
+}
+
+// fills past the capacity, so the last appends are refused
+constexpr int static_list_sum()
+{
+    dynamic_list::static_list<int, 8> list;
+    for (int i = 0; i < 10; i++)
+    {
+        if (!list.append(i))
+            return -1 - i;
+    }
+    return 0;
+}
+
+constexpr int static_list_remove()
+{
+    dynamic_list::static_list<int, 8> list;
+    for (int i = 0; i < 8; i++)
+        list.append(i);
+    list.remove_at(0);
+    list.pop_back();
+
+    int sum = 0;
+    for (int value : list)
+        sum += value;
+    return sum * 10 + static_cast<int>(list.size());
+}
+
+static_assert(static_list_sum() == -9, "the ninth append is refused");
+static_assert(static_list_remove() == (7 + 1 + 2 + 3 + 4 + 5) * 10 + 6, "remove_at moves the last item in");
+
+static void test_static_list()
+{
+    dynamic_list::static_list<long long, 16> list;
+    CHECK(list.empty() && list.capacity() == 16);
+    for (int i = 0; i < 5; i++)
+        list.append(i * 10);
+
+    // the C functions that only read see the same list as a heap list of the same items
+    CHECK(list_len(list.list()) == 5 && list.list()[4] == 40);
+    long long* heap = list_new(long long);
+    for (long long value : list)
+        list_append(heap, value);
+    CHECK(list_hash64(list.list()) == list_hash64(heap) && list_equal(list.list(), heap));
+    list_free(heap);
+
+    while (!list.full())
+        list.append(1);
+    CHECK(list.size() == 16 && list.append(2) == nullptr);
+    list.clear();
+    CHECK(list.empty() && list_len(list.list()) == 0);
+}
+
+static dynamic_list::inline_executor* chained_executor;
+static int chained_left;
+
+// posts the next link from inside the run, with an extra job every other time
+static void chain(void*)
+{
+    if (--chained_left > 0)
+    {
+        chained_executor->post(chain, nullptr);
+        if (chained_left % 2)
+            chained_executor->post([](void*) {}, nullptr);
+    }
+}
+
+static void test_executors()
+{
+    dynamic_list::inline_executor executor;
+    chained_executor = &executor;
+    chained_left = 100000;
+    executor.post(chain, nullptr);
+    CHECK(executor.run() == 100000 + 50000);
+    CHECK(chained_left == 0 && executor.run() == 0);
+
+    dynamic_list::thread_pool_executor pool(4);
+    std::atomic<int> count{0};
+    for (int i = 0; i < 100000; i++)
+        pool.post([](void* argument) { static_cast<std::atomic<int>*>(argument)->fetch_add(1); }, &count);
+    pool.wait();
+    CHECK(count == 100000);
+
+    // the destructor runs what is still queued
+    std::atomic<int> late{0};
+    {
+        dynamic_list::thread_pool_executor closing(2);
+        for (int i = 0; i < 1000; i++)
+            closing.post([](void* argument) { static_cast<std::atomic<int>*>(argument)->fetch_add(1); }, &late);
+    }
+    CHECK(late == 1000);
+}
+
+#ifdef DYNAMIC_LIST_COROUTINES
+struct ChannelTotals
+{
+    std::atomic<long long> sum{0};
+    std::atomic<long long> items{0};
+    std::atomic<int> producers{0};
+};
+
+// sends [first, first + count) in batches of an odd size, and closes the channel after the last producer
+template <class Executor>
+dynamic_list::task produce(dynamic_list::channel<int, Executor>& channel, ChannelTotals& totals, int first, int count)
+{
+    int batch[37];
+    for (int sent = 0; sent < count;)
+    {
+        const int size = count - sent < 37 ? count - sent : 37;
+        for (int i = 0; i < size; i++)
+            batch[i] = first + sent + i;
+        if (co_await channel.send_many(batch, size) != static_cast<std::size_t>(size))
+            break;
+        sent += size;
+    }
+    if (--totals.producers == 0)
+        channel.close();
+}
+
+template <class Executor>
+dynamic_list::task consume(dynamic_list::channel<int, Executor>& channel, ChannelTotals& totals)
+{
+    int batch[50];
+    while (std::size_t count = co_await channel.recv_many(batch, 50))
+    {
+        for (std::size_t i = 0; i < count; i++)
+            totals.sum += batch[i];
+        totals.items += static_cast<long long>(count);
+    }
+}
+
+static void test_channel()
+{
+    {
+        dynamic_list::inline_executor executor;
+        dynamic_list::channel<int, dynamic_list::inline_executor> channel(16, executor);
+        ChannelTotals totals;
+        totals.producers = 2;
+        consume(channel, totals).start(executor);
+        produce(channel, totals, 0, 1000).start(executor);
+        produce(channel, totals, 1000, 1000).start(executor);
+        executor.run();
+        CHECK(totals.items == 2000 && totals.sum == 1999LL * 2000 / 2);
+    }
+
+    dynamic_list::thread_pool_executor executor(4);
+    for (int round = 0; round < 10; round++)
+    {
+        dynamic_list::channel<int> channel(64, executor);
+        ChannelTotals totals;
+        totals.producers = 4;
+        for (int i = 0; i < 3; i++)
+            consume(channel, totals).start(executor);
+        for (int i = 0; i < 4; i++)
+            produce(channel, totals, i * 100000, 100000).start(executor);
+        executor.wait();
+
+        const long long items = 400000;
+        CHECK(totals.items == items && totals.sum == items * (items - 1) / 2);
+    }
+}
+#endif
+
+struct Handle
+{
+    int* value;
+
+    explicit Handle(int v) : value(new int(v)) {}
+    Handle(Handle&& other) noexcept : value(other.value) { other.value = nullptr; }
+    Handle& operator=(Handle&& other) noexcept
+    {
+        std::swap(value, other.value);
+        return *this;
+    }
+    ~Handle() { delete value; }
+};
+
+template <>
+struct dynamic_list::is_trivially_relocatable<Handle> : std::true_type
+{
+};
+
+struct Throwing
+{
+    explicit Throwing(int value)
+    {
+        if (value < 0)
+            throw value;
+    }
+};
+
+// an allocator that can be told to fail, to check a failed grow leaves the items where they were
+struct Failing
+{
+    bool fail = false;
+};
+
+static void* failing_alloc(std::size_t size, void* context)
+{
+    return static_cast<Failing*>(context)->fail ? nullptr : std::malloc(size);
+}
+
+static void* failing_realloc(void* ptr, std::size_t size, void* context)
+{
+    return static_cast<Failing*>(context)->fail ? nullptr : std::realloc(ptr, size);
+}
+
+static void failing_free(void* ptr, void*)
+{
+    std::free(ptr);
+}
+
+static void test_emplace()
+{
+    const std::size_t live_lists = list_allocator_stats(nullptr).live_lists;
+
+    // strings too long for the inline buffer, then short ones that point into themselves, all moved by growing
+    std::string* names = list_new(std::string);
+    for (int i = 0; i < 1000; i++)
+        dynamic_list::emplace_back(names, i % 2 ? 40 + i % 7 : 1 + i % 7, static_cast<char>('a' + i % 26));
+    bool intact = list_len(names) == 1000;
+    for (int i = 0; intact && i < 1000; i++)
+        intact = names[i] == std::string(i % 2 ? 40 + i % 7 : 1 + i % 7, static_cast<char>('a' + i % 26));
+    CHECK(intact);
+
+    dynamic_list::remove_at(names, 0);
+    CHECK(list_len(names) == 999 && names[0] == std::string(40 + 999 % 7, 'a' + 999 % 26));
+    dynamic_list::pop_back(names);
+    dynamic_list::emplace_back(names, "short");
+    CHECK(list_len(names) == 999 && names[998] == "short");
+    dynamic_list::clear(names);
+    CHECK(list_len(names) == 0);
+    dynamic_list::emplace_back(names, "again");
+    dynamic_list::destroy(names);
+
+    // an opted in type grows with realloc
+    Handle* handles = list_new(Handle);
+    for (int i = 0; i < 1000; i++)
+        dynamic_list::emplace_back(handles, i);
+    CHECK(*handles[500].value == 500 && *handles[999].value == 999);
+    dynamic_list::remove_at(handles, 3);
+    CHECK(*handles[3].value == 999);
+    dynamic_list::destroy(handles);
+
+    // a constructor that throws leaves the length alone
+    Throwing* throwing = list_new(Throwing);
+    dynamic_list::emplace_back(throwing, 1);
+    bool thrown = false;
+    try
+    {
+        dynamic_list::emplace_back(throwing, -1);
+    }
+    catch (int)
+    {
+        thrown = true;
+    }
+    CHECK(thrown && list_len(throwing) == 1);
+    list_free(throwing);
+
+    // so does a grow that can't allocate, on either path
+    Failing failing;
+    Allocator allocator = {failing_alloc, failing_realloc, failing_free, &failing, 0, 0, 0};
+    std::string* strings = static_cast<std::string*>(create_list(sizeof(std::string), 2, &allocator));
+    Handle* moved = static_cast<Handle*>(create_list(sizeof(Handle), 2, &allocator));
+    dynamic_list::emplace_back(strings, 30, 'x');
+    dynamic_list::emplace_back(strings, "y");
+    dynamic_list::emplace_back(moved, 1);
+    dynamic_list::emplace_back(moved, 2);
+    failing.fail = true;
+    bool failed = false;
+    try
+    {
+        dynamic_list::emplace_back(strings, "z");
+    }
+    catch (const std::bad_alloc&)
+    {
+        failed = true;
+    }
+    CHECK(failed && list_len(strings) == 2 && strings[0] == std::string(30, 'x') && strings[1] == "y");
+    failed = false;
+    try
+    {
+        dynamic_list::emplace_back(moved, 3);
+    }
+    catch (const std::bad_alloc&)
+    {
+        failed = true;
+    }
+    CHECK(failed && list_len(moved) == 2 && *moved[0].value == 1 && *moved[1].value == 2);
+    failing.fail = false;
+    dynamic_list::destroy(strings);
+    dynamic_list::destroy(moved);
+
+    CHECK(list_allocator_stats(nullptr).live_lists == live_lists);
+}
+
+#ifdef DYNAMIC_LIST_SPAN
+static_assert(std::ranges::contiguous_range<dynamic_list::list_view<int>>);
+static_assert(std::ranges::sized_range<dynamic_list::list_view<const int>>);
+
+static long long sum_span(std::span<const int> items)
+{
+    return std::accumulate(items.begin(), items.end(), 0LL);
+}
+#endif
+
+static void test_view()
+{
+    int* list = list_new(int);
+    const dynamic_list::list_view<int> items = dynamic_list::view(list);
+    CHECK(items.empty() && items.begin() == items.end());
+
+    // the length is read on every call, so appends show up in a view made before them
+    list_append(list, 3);
+    dynamic_list::view(list)[0] = 5;
+    list_append(list, 1);
+    list_append(list, 4);
+    CHECK(dynamic_list::view(list).size() == 3 && list[0] == 5);
+
+    std::sort(dynamic_list::view(list).begin(), dynamic_list::view(list).end());
+    CHECK(list[0] == 1 && list[1] == 4 && list[2] == 5);
+
+#ifdef DYNAMIC_LIST_SPAN
+    std::ranges::sort(dynamic_list::view(list), std::greater<>());
+    CHECK(list[0] == 5 && list[2] == 1);
+    CHECK(sum_span(std::span<int>(dynamic_list::view(list))) == 10);
+#endif
+    list_free(list);
+}
+
+static void test_parallel()
+{
+    dynamic_list::thread_pool_executor executor(4);
+    std::mt19937 random(1);
+
+    // sizes below and above the one that goes to a single thread, and ones that split unevenly
+    for (std::size_t count : {0ul, 1ul, 10ul, 4095ul, 5000ul, 100003ul})
+    {
+        int* list = list_new(int);
+        for (std::size_t i = 0; i < count; i++)
+            list_append(list, static_cast<int>(random() % 1000));
+        int* expected = list_new(int);
+        for (std::size_t i = 0; i < count; i++)
+            list_append(expected, list[i]);
+
+        dynamic_list::parallel_sort(executor, list);
+        std::sort(expected, expected + count);
+        CHECK(std::equal(list, list + count, expected));
+
+        CHECK(dynamic_list::parallel_reduce(executor, list, 0LL) == std::accumulate(list, list + count, 0LL));
+
+        dynamic_list::parallel_transform(executor, list, expected, [](int value) { return value * 2; });
+        bool doubled = true;
+        for (std::size_t i = 0; i < count; i++)
+            doubled = doubled && expected[i] == list[i] * 2;
+        CHECK(doubled);
+
+        dynamic_list::parallel_transform(executor, list, list, [](int value) { return -value; });
+        CHECK(std::is_sorted(list, list + count, std::greater<>()));
+
+        list_free(list);
+        list_free(expected);
+    }
+
+    // items that are moved, not copied, and an order that isn't the default
+    std::string* strings = list_new(std::string);
+    for (int i = 0; i < 20000; i++)
+        dynamic_list::emplace_back(strings, std::to_string(random()));
+    dynamic_list::parallel_sort(executor, strings, std::greater<>());
+    CHECK(list_len(strings) == 20000 && std::is_sorted(strings, strings + 20000, std::greater<>()));
+    dynamic_list::destroy(strings);
+
+    // the first exception reaches the caller, and the pool is still usable after it
+    bool thrown = false;
+    try
+    {
+        dynamic_list::parallel_for(executor, 1000, [](std::size_t begin, std::size_t) {
+            if (begin > 500)
+                throw 7;
+        });
+    }
+    catch (int value)
+    {
+        thrown = value == 7;
+    }
+    CHECK(thrown);
+
+    std::atomic<std::size_t> covered{0};
+    dynamic_list::parallel_for(executor, 1000, [&](std::size_t begin, std::size_t end) { covered += end - begin; });
+    CHECK(covered == 1000);
+}
+
+int main()
+{
+    test_pmr();
+    test_static_list();
+    test_executors();
+#ifdef DYNAMIC_LIST_COROUTINES
+    test_channel();
+#endif
+    test_emplace();
+    test_view();
+    test_parallel();
+
+    if (failures == 0)
+        std::printf("all tests passed\n");
+    return failures;
+}
@@ -0,0 +1,4 @@
+// the implementation for tests.cpp, which has to be compiled as C
+#define DYNAMIC_LIST_ACCOUNTING
+#define DYNAMIC_LIST_IMPL
+#include "dynamic_list.h"
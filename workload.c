@@ -0,0 +1,319 @@
+#define _POSIX_C_SOURCE 199309L
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define DYNAMIC_LIST_IMPL
+#include "dynamic_list.h"
+#include "support.h"
+
+// drives lists through workload shapes seen in services and reports per-operation latency, so a
+// change to list_ensure_capacity or to an allocator can be judged on more than a single loop.
+//
+//     $ gcc workload.c -std=c11 -O3 -o workload
+//     $ ./workload --workload mixed --ops 1000000 --seed 7 --allocator arena
+//
+// workloads:
+//     append  - one list, append only
+//     mixed   - one list held around a target length by random appends and removes
+//     queue   - appends at the tail, consumes from the head, compacting when half is consumed
+//     small   - many short-lived lists of a few items each
+//     huge    - one list grown to --ops items of 64 bytes each
+//
+// allocators:
+//     default - malloc/realloc/free
+//     arena   - bump allocator that never frees; realloc copies into a new block
+
+static unsigned long long now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (unsigned long long)ts.tv_sec * 1000000000ull + (unsigned long long)ts.tv_nsec;
+}
+
+// log-linear buckets: 16 linear steps inside every power of two, about 6% resolution
+#define HISTOGRAM_SUB 16
+#define HISTOGRAM_BUCKETS (64 * HISTOGRAM_SUB)
+
+typedef struct
+{
+    const char* name;
+    unsigned long long counts[HISTOGRAM_BUCKETS];
+    unsigned long long total;
+    unsigned long long sum;
+    unsigned long long max;
+} Histogram;
+
+static size_t histogram_bucket(const unsigned long long value)
+{
+    if (value < HISTOGRAM_SUB)
+        return (size_t)value;
+
+    size_t magnitude = 0;
+    while ((value >> magnitude) >= HISTOGRAM_SUB * 2)
+        magnitude++;
+    return (magnitude + 1) * HISTOGRAM_SUB + (size_t)((value >> magnitude) - HISTOGRAM_SUB);
+}
+
+static unsigned long long histogram_bucket_value(const size_t bucket)
+{
+    if (bucket < HISTOGRAM_SUB)
+        return bucket;
+
+    const size_t magnitude = bucket / HISTOGRAM_SUB - 1;
+    return (unsigned long long)(HISTOGRAM_SUB + bucket % HISTOGRAM_SUB) << magnitude;
+}
+
+static void histogram_record(Histogram* h, const unsigned long long value)
+{
+    h->counts[histogram_bucket(value)]++;
+    h->total++;
+    h->sum += value;
+    if (value > h->max)
+        h->max = value;
+}
+
+static unsigned long long histogram_percentile(const Histogram* h, const double percentile)
+{
+    const unsigned long long target = (unsigned long long)((double)h->total * percentile / 100.0 + 0.5);
+    unsigned long long seen = 0;
+    for (size_t bucket = 0; bucket < HISTOGRAM_BUCKETS; bucket++)
+    {
+        seen += h->counts[bucket];
+        if (seen >= target && seen > 0)
+            return histogram_bucket_value(bucket);
+    }
+    return h->max;
+}
+
+static void histogram_print(const Histogram* h)
+{
+    if (h->total == 0)
+        return;
+
+    printf("%-8s %12llu %10.1f %10llu %10llu %10llu %10llu %12llu\n", h->name, h->total,
+        (double)h->sum / (double)h->total, histogram_percentile(h, 50), histogram_percentile(h, 90),
+        histogram_percentile(h, 99), histogram_percentile(h, 99.9), h->max);
+}
+
+enum
+{
+    OP_APPEND,
+    OP_REMOVE,
+    OP_CREATE,
+    OP_FREE,
+    OP_COUNT,
+};
+
+static Histogram histograms[OP_COUNT] = {
+    {.name = "append"},
+    {.name = "remove"},
+    {.name = "create"},
+    {.name = "free"},
+};
+
+#define TIMED(op, statement) do { \
+    const unsigned long long start_ = now_ns(); \
+    statement; \
+    histogram_record(&histograms[op], now_ns() - start_); \
+} while (0)
+
+typedef struct
+{
+    const char* workload;
+    size_t ops;
+    unsigned long long seed;
+    Allocator* allocator;
+} Options;
+
+static void run_append(const Options* options, Random* random)
+{
+    int* list;
+    TIMED(OP_CREATE, list = list_new_alloc(int, options->allocator));
+    for (size_t i = 0; i < options->ops; i++)
+        TIMED(OP_APPEND, list_append(list, (int)random_next(random)));
+    TIMED(OP_FREE, list_free(list));
+}
+
+static void run_mixed(const Options* options, Random* random)
+{
+    const size_t target = 4096;
+    int* list = list_new_alloc(int, options->allocator);
+
+    for (size_t i = 0; i < options->ops; i++)
+    {
+        // appends are favoured below the target length and removes above it
+        if (list_len(list) == 0 || random_below(random, target * 2) >= list_len(list))
+        {
+            TIMED(OP_APPEND, list_append(list, (int)i));
+        }
+        else
+        {
+            const size_t index = random_below(random, list_len(list));
+            TIMED(OP_REMOVE, list_remove_at(list, index));
+        }
+    }
+
+    list_free(list);
+}
+
+static void run_queue(const Options* options, Random* random)
+{
+    int* list = list_new_alloc(int, options->allocator);
+    size_t head = 0;
+
+    for (size_t i = 0; i < options->ops; i++)
+    {
+        // producers run in bursts, consumers drain at a steady rate
+        const size_t burst = random_below(random, 8);
+        for (size_t j = 0; j < burst; j++)
+            TIMED(OP_APPEND, list_append(list, (int)j));
+
+        for (size_t j = 0; j < 3 && head < list_len(list); j++)
+        {
+            TIMED(OP_REMOVE, {
+                head++;
+                if (head * 2 >= list_len(list))
+                {
+                    memmove(list, list + head, (list_len(list) - head) * sizeof(*list));
+
+                    // popped rather than shrunk by hand, so ASan builds poison the consumed items again
+                    for (; head > 0; head--)
+                        list_pop_back(list);
+                }
+            });
+        }
+    }
+
+    list_free(list);
+}
+
+static void run_small(const Options* options, Random* random)
+{
+    for (size_t i = 0; i < options->ops; i++)
+    {
+        long long* list;
+        TIMED(OP_CREATE, list = list_new_alloc(long long, options->allocator));
+
+        const size_t items = 1 + random_below(random, 24);
+        for (size_t j = 0; j < items; j++)
+            TIMED(OP_APPEND, list_append(list, (long long)j));
+
+        TIMED(OP_FREE, list_free(list));
+    }
+}
+
+typedef struct
+{
+    unsigned long long fields[8];
+} Record;
+
+static void run_huge(const Options* options, Random* random)
+{
+    Record* list;
+    TIMED(OP_CREATE, list = list_new_alloc(Record, options->allocator));
+
+    Record record = {{0}};
+    for (size_t i = 0; i < options->ops; i++)
+    {
+        record.fields[i % 8] = random_next(random);
+        TIMED(OP_APPEND, list_append(list, record));
+    }
+
+    TIMED(OP_FREE, list_free(list));
+}
+
+typedef struct
+{
+    const char* name;
+    void (*run)(const Options* options, Random* random);
+} Workload;
+
+static const Workload workloads[] = {
+    {"append", run_append},
+    {"mixed", run_mixed},
+    {"queue", run_queue},
+    {"small", run_small},
+    {"huge", run_huge},
+};
+
+static void usage(const char* program)
+{
+    fprintf(stderr, "usage: %s [--workload append|mixed|queue|small|huge] [--ops N] [--seed N] "
+        "[--allocator default|arena]\n", program);
+}
+
+int main(int argc, char* argv[])
+{
+    Options options = {"append", 1000000, 1, NULL};
+    const char* allocator = "default";
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (i + 1 >= argc)
+        {
+            usage(argv[0]);
+            return 1;
+        }
+
+        if (strcmp(argv[i], "--workload") == 0)
+            options.workload = argv[++i];
+        else if (strcmp(argv[i], "--ops") == 0)
+            options.ops = strtoull(argv[++i], NULL, 10);
+        else if (strcmp(argv[i], "--seed") == 0)
+            options.seed = strtoull(argv[++i], NULL, 10);
+        else if (strcmp(argv[i], "--allocator") == 0)
+            allocator = argv[++i];
+        else
+        {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    Arena arena = {NULL, 0, 0};
+    Allocator arena_allocator = {
+        .alloc = arena_alloc,
+        .realloc = arena_realloc,
+        .free = arena_free,
+        .context = &arena,
+    };
+
+    if (strcmp(allocator, "arena") == 0)
+    {
+        options.allocator = &arena_allocator;
+    }
+    else if (strcmp(allocator, "default") != 0)
+    {
+        usage(argv[0]);
+        return 1;
+    }
+
+    const Workload* workload = NULL;
+    for (size_t i = 0; i < sizeof(workloads) / sizeof(workloads[0]); i++)
+    {
+        if (strcmp(workloads[i].name, options.workload) == 0)
+            workload = &workloads[i];
+    }
+    if (!workload)
+    {
+        usage(argv[0]);
+        return 1;
+    }
+
+    Random random = {options.seed};
+    const unsigned long long start = now_ns();
+    workload->run(&options, &random);
+    const unsigned long long elapsed = now_ns() - start;
+
+    printf("workload %s, %zu ops, seed %llu, allocator %s, %.3f ms\n\n", workload->name, options.ops,
+        options.seed, allocator, (double)elapsed / 1e6);
+    printf("%-8s %12s %10s %10s %10s %10s %10s %12s\n", "op (ns)", "count", "mean", "p50", "p90", "p99",
+        "p99.9", "max");
+    for (size_t op = 0; op < OP_COUNT; op++)
+        histogram_print(&histograms[op]);
+
+    arena_release(&arena);
+    return 0;
+}